@@ -0,0 +1,723 @@
+
+#include "alloc_tracker.hpp"
+#include "measurements.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <malloc.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <sys/mman.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#   define JSON_BENCHMARKS_NO_MALLOC_INTERPOSITION
+#elif defined(__has_feature)
+#   if __has_feature(address_sanitizer)
+#       define JSON_BENCHMARKS_NO_MALLOC_INTERPOSITION
+#   endif
+#endif
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+const char* trial_phase_name(trial_phase ph) {
+    switch ( ph ) {
+        case trial_phase::prepare: return "prepare";
+        case trial_phase::parse: return "parse";
+        case trial_phase::print: return "print";
+        case trial_phase::free: return "free";
+        case trial_phase::traverse: return "traverse";
+        case trial_phase::count_: break;
+    }
+
+    return "UNKNOWN";
+}
+
+/*************************************************************************************************/
+
+std::size_t alloc_profile::log2_class(std::uint64_t v, std::size_t classes) {
+    std::size_t res = v > 1 ? 64 - __builtin_clzll(v - 1) : 0;
+
+    return res < classes ? res : classes - 1;
+}
+
+std::string alloc_profile::size_histogram_str() const {
+    static const char *suffix[] = {"B", "KB", "MB", "GB"};
+
+    std::string res;
+    for ( auto i = 0u; i < size_classes; ++i ) {
+        if ( !size_histogram[i] ) {
+            continue;
+        }
+
+        // the powers of two are exact in the binary units
+        std::size_t unit = std::min<std::size_t>(i / 10, 3);
+        res += res.empty() ? "" : ", ";
+        res += i == size_classes - 1 ? ">" : "<=";
+        res += std::to_string((1ull << i) >> (unit * 10));
+        res += " ";
+        res += suffix[unit];
+        res += ": ";
+        res += std::to_string(size_histogram[i]);
+    }
+
+    return res.empty() ? "none" : res;
+}
+
+std::string alloc_profile::lifetime_histogram_str() const {
+    std::string res;
+    for ( auto i = 0u; i < lifetime_classes; ++i ) {
+        if ( !lifetime_histogram[i] ) {
+            continue;
+        }
+
+        res += res.empty() ? "" : ", ";
+        res += i == lifetime_classes - 1 ? ">" : "<=";
+        res += human_time(1ull << i);
+        res += ": ";
+        res += std::to_string(lifetime_histogram[i]);
+    }
+
+    return res.empty() ? "none" : res;
+}
+
+std::ostream& operator<< (std::ostream &os, const alloc_profile &p) {
+    if ( !p.collected ) {
+        return os << "n/a";
+    }
+
+    os << "allocs: " << p.allocations << ", freed in trial: " << p.freed
+       << ", peak live: " << human_size(p.peak_live_bytes);
+    if ( p.untracked ) {
+        os << ", untracked: " << p.untracked;
+    }
+
+    return os
+        << ", sizes: [" << p.size_histogram_str() << "]"
+        << ", lifetimes: [" << p.lifetime_histogram_str() << "]"
+    ;
+}
+
+/*************************************************************************************************/
+
+namespace {
+
+struct block_entry {
+    std::uintptr_t ptr; // zero for the empty slot
+    std::uint64_t size;
+    std::uint64_t time; // phase_timer ticks
+    std::uint32_t phase;
+    std::uint32_t reserved;
+};
+
+// the table of the live blocks starts with 64K slots and is doubled when it's 3/4 full.
+// the memory is taken by mmap() directly, so the tracker never calls malloc() itself
+static constexpr std::size_t table_min_bits = 16;
+static constexpr std::size_t table_max_bits = 28;
+
+// the allocations aggregated by the call stack
+static constexpr std::size_t max_frames = 16;
+static constexpr std::size_t stacks_bits = 14;
+static constexpr std::size_t stacks_size = std::size_t{1} << stacks_bits;
+
+struct stack_entry {
+    std::uint64_t hash; // zero for the empty slot
+    std::uint32_t phase;
+    std::uint32_t depth;
+    std::uintptr_t frames[max_frames];
+    std::uint64_t bytes;
+    std::uint64_t allocations;
+};
+
+// the odd points are dropped when the buffer is full
+static constexpr std::size_t timeline_capacity = 64 * 1024;
+
+struct tracker_state {
+    std::atomic<bool> active;
+    std::atomic<bool> suspended;
+    bool backtraces;
+    std::size_t timeline_interval;
+    std::size_t timeline_size;
+    alloc_timeline_point *timeline;
+    std::uint64_t allocations;
+    std::uint64_t live_bytes;
+    // the frames above belong to the harness, and the stack pointer
+    // of the benchmark thread never goes above during the trial
+    std::uintptr_t stack_top;
+    stack_entry *stacks;
+    std::atomic<bool> intercepted;
+    std::atomic<std::uint32_t> phase;
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+    block_entry *table;
+    std::size_t bits;
+    std::size_t used;
+    alloc_profile profiles[static_cast<std::size_t>(trial_phase::count_)];
+};
+
+tracker_state g_state;
+
+struct spin_lock {
+    spin_lock() { while ( g_state.lock.test_and_set(std::memory_order_acquire) ) {} }
+    ~spin_lock() { g_state.lock.clear(std::memory_order_release); }
+};
+
+std::size_t table_size(std::size_t bits) { return std::size_t{1} << bits; }
+
+std::size_t home_slot(std::uintptr_t ptr, std::size_t bits) {
+    return static_cast<std::size_t>(((ptr >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+block_entry* map_table(std::size_t bits) {
+    void *addr = ::mmap(nullptr, table_size(bits) * sizeof(block_entry), PROT_READ | PROT_WRITE
+        ,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return addr == MAP_FAILED ? nullptr : static_cast<block_entry *>(addr);
+}
+
+void unmap_table(block_entry *table, std::size_t bits) {
+    ::munmap(table, table_size(bits) * sizeof(block_entry));
+}
+
+block_entry& find_slot(block_entry *table, std::size_t bits, std::uintptr_t key) {
+    const auto mask = table_size(bits) - 1;
+    auto idx = home_slot(key, bits);
+    while ( table[idx].ptr && table[idx].ptr != key ) {
+        idx = (idx + 1) & mask;
+    }
+
+    return table[idx];
+}
+
+// false when the table can't grow anymore
+bool grow_table() {
+    if ( g_state.bits >= table_max_bits ) {
+        return false;
+    }
+
+    const auto bits = g_state.bits + 1;
+    auto *table = map_table(bits);
+    if ( !table ) {
+        return false;
+    }
+
+    for ( auto i = 0u; i < table_size(g_state.bits); ++i ) {
+        if ( g_state.table[i].ptr ) {
+            find_slot(table, bits, g_state.table[i].ptr) = g_state.table[i];
+        }
+    }
+    unmap_table(g_state.table, g_state.bits);
+    g_state.table = table;
+    g_state.bits = bits;
+
+    return true;
+}
+
+// walks the chain of the frame pointers: [0] is the caller's frame pointer, [1] is the return address.
+// every frame pointer is checked to be within the stack of the benchmark thread,
+// so the walk through a function compiled without the frame pointers is safe, but stops early
+__attribute__((noinline))
+std::size_t capture_stack(std::uintptr_t *frames) {
+    auto *fp = static_cast<const std::uintptr_t *>(__builtin_frame_address(0));
+    const auto lo = reinterpret_cast<std::uintptr_t>(fp);
+    const auto hi = g_state.stack_top;
+
+    // capture_stack() and on_alloc() are skipped
+    std::size_t skip = 2;
+    std::size_t depth = 0;
+    while ( depth < max_frames ) {
+        const auto addr = reinterpret_cast<std::uintptr_t>(fp);
+        if ( addr < lo || addr + 2 * sizeof(std::uintptr_t) > hi || (addr % sizeof(std::uintptr_t)) ) {
+            break;
+        }
+
+        const auto next = fp[0];
+        const auto ret = fp[1];
+        if ( !ret ) {
+            break;
+        }
+        if ( skip ) {
+            --skip;
+        } else {
+            frames[depth++] = ret;
+        }
+        if ( next <= addr ) {
+            break;
+        }
+        fp = reinterpret_cast<const std::uintptr_t *>(next);
+    }
+
+    return depth;
+}
+
+// must be called under the lock
+void record_stack(std::uint32_t phase, const std::uintptr_t *frames, std::size_t depth, std::size_t size) {
+    if ( !g_state.stacks || !depth ) {
+        return;
+    }
+
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull ^ phase;
+    for ( auto i = 0u; i < depth; ++i ) {
+        hash = (hash ^ frames[i]) * 1099511628211ull;
+    }
+    hash |= 1;
+
+    const auto mask = stacks_size - 1;
+    for ( auto idx = hash & mask, probes = std::size_t{0}; probes < stacks_size; idx = (idx + 1) & mask, ++probes ) {
+        auto &e = g_state.stacks[idx];
+        if ( e.hash == hash && e.phase == phase && e.depth == depth
+            && std::memcmp(e.frames, frames, depth * sizeof(frames[0])) == 0 )
+        {
+            e.bytes += size;
+            ++e.allocations;
+
+            return;
+        }
+        if ( !e.hash ) {
+            e.hash = hash;
+            e.phase = phase;
+            e.depth = static_cast<std::uint32_t>(depth);
+            std::memcpy(e.frames, frames, depth * sizeof(frames[0]));
+            e.bytes = size;
+            e.allocations = 1;
+
+            return;
+        }
+    }
+    // the table is full, the stack is dropped
+}
+
+__attribute__((noinline))
+void on_alloc(void *ptr, std::size_t size) {
+    if ( !ptr || !g_state.active.load(std::memory_order_relaxed) || g_state.suspended.load(std::memory_order_relaxed) ) {
+        return;
+    }
+
+    const auto phase = g_state.phase.load(std::memory_order_relaxed);
+    // only parse and print are the interesting ones
+    std::uintptr_t frames[max_frames];
+    std::size_t depth = 0;
+    if ( g_state.backtraces
+        && (phase == static_cast<std::uint32_t>(trial_phase::parse)
+            || phase == static_cast<std::uint32_t>(trial_phase::print)) )
+    {
+        depth = capture_stack(frames);
+    }
+
+    spin_lock lock;
+    record_stack(phase, frames, depth, size);
+
+    auto &prof = g_state.profiles[phase];
+    ++prof.allocations;
+    ++prof.size_histogram[alloc_profile::log2_class(size, alloc_profile::size_classes)];
+
+    // the linear probing degrades quickly beyond 3/4
+    if ( !g_state.table || (g_state.used >= table_size(g_state.bits) / 4 * 3 && !grow_table()) ) {
+        // can't be subtracted on free(), so it's not counted as live
+        ++prof.untracked;
+
+        return;
+    }
+
+    g_state.live_bytes += size;
+    prof.peak_live_bytes = std::max(prof.peak_live_bytes, g_state.live_bytes);
+    ++g_state.allocations;
+    if ( g_state.timeline && g_state.allocations % g_state.timeline_interval == 0 ) {
+        if ( g_state.timeline_size == timeline_capacity ) {
+            for ( auto i = 0u; i < timeline_capacity / 2; ++i ) {
+                g_state.timeline[i] = g_state.timeline[i * 2 + 1];
+            }
+            g_state.timeline_size = timeline_capacity / 2;
+            g_state.timeline_interval *= 2;
+        }
+        if ( g_state.allocations % g_state.timeline_interval == 0 ) {
+            g_state.timeline[g_state.timeline_size++] = {g_state.allocations, g_state.live_bytes, phase};
+        }
+    }
+
+    const auto key = reinterpret_cast<std::uintptr_t>(ptr);
+    auto &e = find_slot(g_state.table, g_state.bits, key);
+    if ( !e.ptr ) {
+        ++g_state.used;
+    }
+
+    e.ptr = key;
+    e.size = size;
+    e.time = phase_timer::now();
+    e.phase = phase;
+}
+
+void on_free(void *ptr) {
+    if ( !ptr || !g_state.active.load(std::memory_order_relaxed) ) {
+        return;
+    }
+
+    spin_lock lock;
+    if ( !g_state.table ) {
+        return;
+    }
+
+    const auto key = reinterpret_cast<std::uintptr_t>(ptr);
+    auto &e = find_slot(g_state.table, g_state.bits, key);
+    // allocated before the tracking was started
+    if ( !e.ptr ) {
+        return;
+    }
+
+    g_state.live_bytes -= e.size;
+
+    auto &prof = g_state.profiles[e.phase];
+    ++prof.freed;
+    ++prof.lifetime_histogram[alloc_profile::log2_class(
+        phase_timer::to_ns(phase_timer::now() - e.time), alloc_profile::lifetime_classes)];
+
+    // the backward shift deletion keeps the probe sequences unbroken without tombstones
+    const auto mask = table_size(g_state.bits) - 1;
+    auto idx = static_cast<std::size_t>(&e - g_state.table);
+    for ( auto next = (idx + 1) & mask; g_state.table[next].ptr; next = (next + 1) & mask ) {
+        const auto home = home_slot(g_state.table[next].ptr, g_state.bits);
+        const bool movable = idx <= next
+            ? (home <= idx || home > next)
+            : (home <= idx && home > next)
+        ;
+        if ( movable ) {
+            g_state.table[idx] = g_state.table[next];
+            idx = next;
+        }
+    }
+    g_state.table[idx].ptr = 0;
+    --g_state.used;
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
+bool alloc_tracker::available() {
+    return g_state.intercepted.load(std::memory_order_relaxed);
+}
+
+void alloc_tracker::start(bool backtraces, std::size_t timeline_interval) {
+    stop();
+
+    // the fresh mapping is zero-filled, which means empty
+    if ( g_state.table ) {
+        unmap_table(g_state.table, g_state.bits);
+    }
+    if ( g_state.stacks ) {
+        ::munmap(g_state.stacks, stacks_size * sizeof(stack_entry));
+        g_state.stacks = nullptr;
+    }
+    if ( backtraces ) {
+        void *addr = ::mmap(nullptr, stacks_size * sizeof(stack_entry), PROT_READ | PROT_WRITE
+            ,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        g_state.stacks = addr == MAP_FAILED ? nullptr : static_cast<stack_entry *>(addr);
+    }
+    g_state.backtraces = backtraces;
+    if ( g_state.timeline ) {
+        ::munmap(g_state.timeline, timeline_capacity * sizeof(alloc_timeline_point));
+        g_state.timeline = nullptr;
+    }
+    if ( timeline_interval ) {
+        void *addr = ::mmap(nullptr, timeline_capacity * sizeof(alloc_timeline_point), PROT_READ | PROT_WRITE
+            ,MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        g_state.timeline = addr == MAP_FAILED ? nullptr : static_cast<alloc_timeline_point *>(addr);
+    }
+    g_state.timeline_interval = timeline_interval;
+    g_state.timeline_size = 0;
+    g_state.allocations = 0;
+    g_state.live_bytes = 0;
+    g_state.stack_top = reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0));
+    g_state.bits = table_min_bits;
+    g_state.table = map_table(g_state.bits);
+    g_state.used = 0;
+    g_state.suspended.store(false, std::memory_order_relaxed);
+    g_state.phase.store(static_cast<std::uint32_t>(trial_phase::prepare), std::memory_order_relaxed);
+    for ( auto &it: g_state.profiles ) {
+        it = alloc_profile{};
+        it.collected = true;
+    }
+    // calibrates the timer, if not yet
+    phase_timer::now();
+
+    g_state.active.store(true, std::memory_order_release);
+}
+
+void alloc_tracker::stop() {
+    g_state.active.store(false, std::memory_order_release);
+    // waits for the calls which are still in progress
+    spin_lock lock;
+}
+
+void alloc_tracker::suspend() {
+    g_state.suspended.store(true, std::memory_order_relaxed);
+}
+
+void alloc_tracker::resume() {
+    g_state.suspended.store(false, std::memory_order_relaxed);
+}
+
+void alloc_tracker::set_phase(trial_phase ph) {
+    g_state.phase.store(static_cast<std::uint32_t>(ph), std::memory_order_relaxed);
+    if ( !g_state.active.load(std::memory_order_relaxed) ) {
+        return;
+    }
+
+    spin_lock lock;
+    auto &prof = g_state.profiles[static_cast<std::size_t>(ph)];
+    prof.live_at_start = g_state.live_bytes;
+    prof.peak_live_bytes = g_state.live_bytes;
+}
+
+const alloc_profile& alloc_tracker::profile(trial_phase ph) {
+    return g_state.profiles[static_cast<std::size_t>(ph)];
+}
+
+namespace {
+
+// the demangled function name when the symbol is exported (see -rdynamic), otherwise module+offset
+std::string symbolize(std::uintptr_t addr) {
+    // the return address points to the instruction after the call
+    Dl_info info;
+    if ( !::dladdr(reinterpret_cast<void *>(addr - 1), &info) ) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "0x%zx", static_cast<std::size_t>(addr));
+
+        return buf;
+    }
+
+    if ( info.dli_sname ) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string res = status == 0 && demangled ? demangled : info.dli_sname;
+        std::free(demangled);
+
+        // the template arguments of the STL make it unreadable
+        static const std::size_t max_length = 120;
+        if ( res.size() > max_length ) {
+            res.resize(max_length);
+            res += "...";
+        }
+
+        return res;
+    }
+
+    const char *fname = info.dli_fname ? info.dli_fname : "?";
+    const char *slash = std::strrchr(fname, '/');
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "+0x%zx", static_cast<std::size_t>(addr - reinterpret_cast<std::uintptr_t>(info.dli_fbase)));
+
+    return std::string{slash ? slash + 1 : fname} + buf;
+}
+
+} // anon ns
+
+std::vector<alloc_timeline_point> alloc_tracker::timeline() {
+    if ( !g_state.timeline || g_state.active.load(std::memory_order_acquire) ) {
+        return {};
+    }
+
+    return {g_state.timeline, g_state.timeline + g_state.timeline_size};
+}
+
+std::vector<alloc_site> alloc_tracker::top_sites(trial_phase ph, std::size_t n) {
+    std::vector<alloc_site> res;
+    if ( !g_state.stacks || g_state.active.load(std::memory_order_acquire) ) {
+        return res;
+    }
+
+    std::vector<const stack_entry *> entries;
+    for ( auto i = 0u; i < stacks_size; ++i ) {
+        const auto &e = g_state.stacks[i];
+        if ( e.hash && e.phase == static_cast<std::uint32_t>(ph) ) {
+            entries.push_back(&e);
+        }
+    }
+
+    n = std::min(n, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + n, entries.end()
+        ,[](const stack_entry *l, const stack_entry *r) { return l->bytes > r->bytes; }
+    );
+
+    for ( auto i = 0u; i < n; ++i ) {
+        alloc_site site{};
+        for ( auto j = 0u; j < entries[i]->depth; ++j ) {
+            site.stack += j ? " <- " : "";
+            site.stack += symbolize(entries[i]->frames[j]);
+        }
+        site.bytes = entries[i]->bytes;
+        site.allocations = entries[i]->allocations;
+
+        res.push_back(std::move(site));
+    }
+
+    return res;
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+/*************************************************************************************************/
+
+#ifndef JSON_BENCHMARKS_NO_MALLOC_INTERPOSITION
+
+namespace {
+
+using malloc_fnptr = void* (*)(std::size_t);
+using free_fnptr = void (*)(void *);
+using calloc_fnptr = void* (*)(std::size_t, std::size_t);
+using realloc_fnptr = void* (*)(void *, std::size_t);
+using memalign_fnptr = void* (*)(std::size_t, std::size_t);
+using posix_memalign_fnptr = int (*)(void **, std::size_t, std::size_t);
+using aligned_alloc_fnptr = void* (*)(std::size_t, std::size_t);
+using valloc_fnptr = void* (*)(std::size_t);
+
+struct next_allocator {
+    malloc_fnptr malloc;
+    free_fnptr free;
+    calloc_fnptr calloc;
+    realloc_fnptr realloc;
+    memalign_fnptr memalign;
+    posix_memalign_fnptr posix_memalign;
+    aligned_alloc_fnptr aligned_alloc;
+    valloc_fnptr valloc;
+};
+
+// dlsym() allocates, so the allocations made while resolving are served from here
+alignas(16) char g_bootstrap_buf[64 * 1024];
+std::size_t g_bootstrap_used;
+bool g_resolving;
+
+bool is_bootstrap(const void *ptr) {
+    return ptr >= g_bootstrap_buf && ptr < g_bootstrap_buf + sizeof(g_bootstrap_buf);
+}
+
+void* bootstrap_alloc(std::size_t size) {
+    size = (size + 15) & ~std::size_t{15};
+    if ( g_bootstrap_used + size > sizeof(g_bootstrap_buf) ) {
+        return nullptr;
+    }
+    void *ptr = g_bootstrap_buf + g_bootstrap_used;
+    g_bootstrap_used += size;
+
+    return ptr;
+}
+
+const next_allocator& next() {
+    static next_allocator res = []{
+        next_allocator r{};
+        g_resolving = true;
+        r.malloc = reinterpret_cast<malloc_fnptr>(::dlsym(RTLD_NEXT, "malloc"));
+        r.free = reinterpret_cast<free_fnptr>(::dlsym(RTLD_NEXT, "free"));
+        r.calloc = reinterpret_cast<calloc_fnptr>(::dlsym(RTLD_NEXT, "calloc"));
+        r.realloc = reinterpret_cast<realloc_fnptr>(::dlsym(RTLD_NEXT, "realloc"));
+        r.memalign = reinterpret_cast<memalign_fnptr>(::dlsym(RTLD_NEXT, "memalign"));
+        r.posix_memalign = reinterpret_cast<posix_memalign_fnptr>(::dlsym(RTLD_NEXT, "posix_memalign"));
+        r.aligned_alloc = reinterpret_cast<aligned_alloc_fnptr>(::dlsym(RTLD_NEXT, "aligned_alloc"));
+        r.valloc = reinterpret_cast<valloc_fnptr>(::dlsym(RTLD_NEXT, "valloc"));
+        g_resolving = false;
+        json_benchmarks::g_state.intercepted.store(true, std::memory_order_relaxed);
+
+        return r;
+    }();
+
+    return res;
+}
+
+} // anon ns
+
+extern "C" {
+
+void* malloc(std::size_t size) noexcept {
+    if ( g_resolving ) {
+        return bootstrap_alloc(size);
+    }
+
+    void *ptr = next().malloc(size);
+    json_benchmarks::on_alloc(ptr, size);
+
+    return ptr;
+}
+
+void free(void *ptr) noexcept {
+    if ( !ptr || is_bootstrap(ptr) ) {
+        return;
+    }
+
+    json_benchmarks::on_free(ptr);
+    next().free(ptr);
+}
+
+void* calloc(std::size_t n, std::size_t size) noexcept {
+    if ( g_resolving ) {
+        // the static buffer is zero-initialized and is never reused
+        return bootstrap_alloc(n * size);
+    }
+
+    void *ptr = next().calloc(n, size);
+    json_benchmarks::on_alloc(ptr, n * size);
+
+    return ptr;
+}
+
+void* realloc(void *ptr, std::size_t size) noexcept {
+    if ( is_bootstrap(ptr) ) {
+        void *res = malloc(size);
+        if ( res ) {
+            const auto avail = static_cast<std::size_t>(g_bootstrap_buf + sizeof(g_bootstrap_buf) - static_cast<char *>(ptr));
+            std::memcpy(res, ptr, size < avail ? size : avail);
+        }
+
+        return res;
+    }
+
+    // accounted as free() followed by malloc()
+    json_benchmarks::on_free(ptr);
+    void *res = next().realloc(ptr, size);
+    json_benchmarks::on_alloc(res, size);
+
+    return res;
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept {
+    void *ptr = next().memalign(alignment, size);
+    json_benchmarks::on_alloc(ptr, size);
+
+    return ptr;
+}
+
+int posix_memalign(void **ptr, std::size_t alignment, std::size_t size) noexcept {
+    int res = next().posix_memalign(ptr, alignment, size);
+    if ( res == 0 ) {
+        json_benchmarks::on_alloc(*ptr, size);
+    }
+
+    return res;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+    void *ptr = next().aligned_alloc(alignment, size);
+    json_benchmarks::on_alloc(ptr, size);
+
+    return ptr;
+}
+
+void* valloc(std::size_t size) noexcept {
+    void *ptr = next().valloc(size);
+    json_benchmarks::on_alloc(ptr, size);
+
+    return ptr;
+}
+
+} // extern "C"
+
+#endif // JSON_BENCHMARKS_NO_MALLOC_INTERPOSITION
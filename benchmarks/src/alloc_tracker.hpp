@@ -0,0 +1,112 @@
+#ifndef JSON_BENCHMARKS_ALLOC_TRACKER_HPP
+#define JSON_BENCHMARKS_ALLOC_TRACKER_HPP
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+enum class trial_phase {
+     prepare
+    ,parse
+    ,print
+    ,free
+    ,traverse
+    ,count_ // must be the last
+};
+
+const char* trial_phase_name(trial_phase ph);
+
+// the allocations made in one phase of a trial
+struct alloc_profile {
+    static constexpr std::size_t size_classes = 40;
+    static constexpr std::size_t lifetime_classes = 40;
+
+    bool collected;          // false when the phase was not profiled
+    std::uint64_t allocations;
+    std::uint64_t untracked; // the allocations which didn't fit into the table of the live blocks
+    // [i] is the number of the allocations with the size in (2^(i-1) .. 2^i] bytes
+    std::uint64_t size_histogram[size_classes];
+    // [i] is the number of the blocks allocated in this phase
+    // and freed within (2^(i-1) .. 2^i] nanoseconds, in any phase of the same trial
+    std::uint64_t lifetime_histogram[lifetime_classes];
+    std::uint64_t freed;     // the blocks allocated in this phase and freed in the same trial
+    // the bytes of the blocks allocated since the trial start and not yet freed
+    std::uint64_t live_at_start;
+    std::uint64_t peak_live_bytes; // the high-water mark during the phase
+
+    alloc_profile()
+        :collected{}
+        ,allocations{}
+        ,untracked{}
+        ,size_histogram{}
+        ,lifetime_histogram{}
+        ,freed{}
+        ,live_at_start{}
+        ,peak_live_bytes{}
+    {}
+
+    // the index of the log2 bucket, the last one collects everything beyond
+    static std::size_t log2_class(std::uint64_t v, std::size_t classes);
+
+    // "<=32 B: 100, <=64 B: 20", the empty classes are skipped
+    std::string size_histogram_str() const;
+    // "<=1.024 us: 100, <=2.048 us: 20", the empty classes are skipped
+    std::string lifetime_histogram_str() const;
+
+    friend std::ostream& operator<< (std::ostream &os, const alloc_profile &p);
+};
+
+// the live bytes sampled after each N allocations of a trial
+struct alloc_timeline_point {
+    std::uint64_t allocation; // the number of the allocations since the trial start
+    std::uint64_t live_bytes;
+    std::uint32_t phase;      // trial_phase
+};
+
+// the call stack which allocated the memory in one phase of a trial
+struct alloc_site {
+    std::string stack; // symbolized, the innermost frame first
+    std::uint64_t bytes;
+    std::uint64_t allocations;
+};
+
+// intercepts malloc()/free() and friends for the whole process.
+// the tracking is off by default, in which case every call is forwarded
+// to the next allocator in the chain (malloc-stat.so, then libc) after a single flag check.
+// the live blocks are kept in a table mapped by mmap(), so the tracker never calls malloc() itself.
+struct alloc_tracker {
+    // false when the interposition is not in effect, e.g. in the ASan builds
+    static bool available();
+
+    // clears the profiles and enables the tracking.
+    // with 'backtraces' the call stacks of the parse and print allocations are recorded,
+    // which requires the frame pointers (see ALLOC_BACKTRACES in CMakeLists.txt),
+    // otherwise the stacks are truncated at the first function compiled without them.
+    // with non-zero 'timeline_interval' the live bytes are sampled after each such number
+    // of the allocations, the interval is doubled when the timeline buffer is full
+    static void start(bool backtraces = false, std::size_t timeline_interval = 0);
+    // disables the tracking, the profiles stay available
+    static void stop();
+    // the allocations between suspend() and resume() are not tracked, are used for the buffers
+    // of the harness itself. the blocks tracked before are still accounted when freed
+    static void suspend();
+    static void resume();
+
+    // the phase the next allocations are attributed to
+    static void set_phase(trial_phase ph);
+    static const alloc_profile& profile(trial_phase ph);
+    // the 'n' call stacks which allocated most of the bytes in the phase
+    static std::vector<alloc_site> top_sites(trial_phase ph, std::size_t n);
+    static std::vector<alloc_timeline_point> timeline();
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_ALLOC_TRACKER_HPP
@@ -0,0 +1,362 @@
+
+#include "allocators.hpp"
+
+#include <ostream>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+const char* allocator_kind_name(allocator_kind k) {
+    switch ( k ) {
+        case allocator_kind::system: return "system";
+        case allocator_kind::arena: return "arena";
+        case allocator_kind::pool: return "pool";
+        case allocator_kind::freelist: return "freelist";
+        case allocator_kind::count_: break;
+    }
+
+    return "UNKNOWN";
+}
+
+std::ostream& operator<< (std::ostream &os, allocator_kind k) {
+    return os << allocator_kind_name(k);
+}
+
+/*************************************************************************************************/
+
+namespace {
+
+constexpr std::size_t alignment = 16;
+constexpr std::size_t arena_chunk_size = 1u << 20;
+// most of the DOM nodes of the libraries fit into one block
+constexpr std::size_t pool_block_size = 64;
+constexpr std::size_t pool_chunk_size = 64u * 1024u;
+// the size classes of the free-list are 16 .. 4096 bytes
+constexpr std::size_t min_class_shift = 4;
+constexpr std::size_t max_class_shift = 12;
+constexpr std::size_t size_classes = max_class_shift - min_class_shift + 1;
+
+// precedes each block of the pool and the free-list, the arena blocks have no header
+enum : std::uint32_t {
+     block_pooled
+    ,block_cached
+    ,block_large // the bigger ones, from malloc() directly
+};
+
+struct alignas(alignment) block_header {
+    std::uint32_t tag;
+    std::uint32_t size_class;
+    std::size_t capacity;
+};
+
+struct alignas(alignment) chunk {
+    chunk *next;
+    std::size_t size; // of the data following the chunk header
+    std::size_t used;
+
+    char* data() { return reinterpret_cast<char *>(this + 1); }
+};
+
+struct free_node {
+    free_node *next;
+};
+
+std::size_t align_up(std::size_t v) {
+    return (v + alignment - 1) & ~(alignment - 1);
+}
+
+chunk* new_chunk(std::size_t size) {
+    auto *c = static_cast<chunk *>(std::malloc(sizeof(chunk) + size));
+    if ( c ) {
+        c->next = nullptr;
+        c->size = size;
+        c->used = 0;
+    }
+
+    return c;
+}
+
+void free_chunks(chunk *c) {
+    while ( c ) {
+        auto *next = c->next;
+        std::free(c);
+        c = next;
+    }
+}
+
+void* init_block(void *p, std::uint32_t tag, std::uint32_t size_class, std::size_t capacity) {
+    if ( !p ) {
+        return nullptr;
+    }
+    auto *hdr = static_cast<block_header *>(p);
+    hdr->tag = tag;
+    hdr->size_class = size_class;
+    hdr->capacity = capacity;
+
+    return hdr + 1;
+}
+
+block_header* header_of(void *ptr) {
+    return static_cast<block_header *>(ptr) - 1;
+}
+
+struct thread_state {
+    // arena
+    chunk *arena_head = nullptr;
+    chunk *arena_tail = nullptr;
+    chunk *arena_current = nullptr;
+    char *arena_last = nullptr; // the last block, may be grown in place
+    // pool
+    chunk *pool_chunks = nullptr;
+    free_node *pool_free = nullptr;
+    // free-list
+    free_node *cached[size_classes] = {};
+
+    ~thread_state() { release(); }
+
+    void release() {
+        free_chunks(arena_head);
+        arena_head = arena_tail = arena_current = nullptr;
+        arena_last = nullptr;
+
+        free_chunks(pool_chunks);
+        pool_chunks = nullptr;
+        pool_free = nullptr;
+
+        for ( auto &list: cached ) {
+            while ( list ) {
+                auto *next = list->next;
+                std::free(list);
+                list = next;
+            }
+        }
+    }
+
+    void* arena_malloc(std::size_t size) {
+        size = align_up(size ? size : 1);
+        // the chunks after the current one are the rewound ones
+        for ( auto *c = arena_current; c; c = c->next ) {
+            if ( c->size - c->used >= size ) {
+                arena_current = c;
+                arena_last = c->data() + c->used;
+                c->used += size;
+
+                return arena_last;
+            }
+        }
+
+        auto *c = new_chunk(std::max(arena_chunk_size, size));
+        if ( !c ) {
+            return nullptr;
+        }
+        if ( arena_tail ) {
+            arena_tail->next = c;
+        } else {
+            arena_head = c;
+        }
+        arena_tail = arena_current = c;
+        arena_last = c->data();
+        c->used = size;
+
+        return arena_last;
+    }
+
+    void* arena_realloc(void *ptr, std::size_t old_size, std::size_t size) {
+        if ( ptr && ptr == arena_last ) {
+            const auto offset = static_cast<std::size_t>(arena_last - arena_current->data());
+            const auto needed = offset + align_up(size ? size : 1);
+            if ( needed <= arena_current->size ) {
+                arena_current->used = needed;
+
+                return ptr;
+            }
+        }
+
+        void *res = arena_malloc(size);
+        if ( res && ptr ) {
+            std::memcpy(res, ptr, std::min(old_size, size));
+        }
+
+        return res;
+    }
+
+    void arena_reset() {
+        for ( auto *c = arena_head; c; c = c->next ) {
+            c->used = 0;
+        }
+        arena_current = arena_head;
+        arena_last = nullptr;
+    }
+
+    void* large_malloc(std::size_t size) {
+        return init_block(std::malloc(sizeof(block_header) + size), block_large, 0, size);
+    }
+
+    void* pool_malloc(std::size_t size) {
+        if ( size > pool_block_size ) {
+            return large_malloc(size);
+        }
+
+        if ( !pool_free ) {
+            auto *c = new_chunk(pool_chunk_size);
+            if ( !c ) {
+                return nullptr;
+            }
+            c->next = pool_chunks;
+            pool_chunks = c;
+
+            static constexpr auto stride = sizeof(block_header) + pool_block_size;
+            for ( auto off = 0u; off + stride <= c->size; off += stride ) {
+                auto *node = reinterpret_cast<free_node *>(c->data() + off);
+                node->next = pool_free;
+                pool_free = node;
+            }
+        }
+
+        auto *node = pool_free;
+        pool_free = node->next;
+
+        return init_block(node, block_pooled, 0, pool_block_size);
+    }
+
+    void* freelist_malloc(std::size_t size) {
+        auto shift = min_class_shift;
+        while ( shift <= max_class_shift && (std::size_t{1} << shift) < size ) {
+            ++shift;
+        }
+        if ( shift > max_class_shift ) {
+            return large_malloc(size);
+        }
+
+        const auto size_class = static_cast<std::uint32_t>(shift - min_class_shift);
+        void *block = cached[size_class];
+        if ( block ) {
+            cached[size_class] = cached[size_class]->next;
+        } else {
+            block = std::malloc(sizeof(block_header) + (std::size_t{1} << shift));
+        }
+
+        return init_block(block, block_cached, size_class, std::size_t{1} << shift);
+    }
+
+    void block_free(void *ptr) {
+        auto *hdr = header_of(ptr);
+        switch ( hdr->tag ) {
+            case block_pooled: {
+                auto *node = reinterpret_cast<free_node *>(hdr);
+                node->next = pool_free;
+                pool_free = node;
+                break;
+            }
+            case block_cached: {
+                auto *node = reinterpret_cast<free_node *>(hdr);
+                auto &list = cached[hdr->size_class];
+                node->next = list;
+                list = node;
+                break;
+            }
+            default: {
+                std::free(hdr);
+                break;
+            }
+        }
+    }
+
+    void* block_realloc(void *ptr, std::size_t size, void* (thread_state::*alloc)(std::size_t)) {
+        if ( !ptr ) {
+            return (this->*alloc)(size);
+        }
+        const auto capacity = header_of(ptr)->capacity;
+        if ( size <= capacity ) {
+            return ptr;
+        }
+
+        void *res = (this->*alloc)(size);
+        if ( res ) {
+            std::memcpy(res, ptr, capacity);
+            block_free(ptr);
+        }
+
+        return res;
+    }
+};
+
+std::atomic<allocator_kind> s_kind{allocator_kind::system};
+thread_local thread_state s_state;
+
+} // anon ns
+
+/*************************************************************************************************/
+
+// the function-local static is constructed before the first listener is added
+static std::vector<allocator_listener>& allocator_listeners() {
+    static std::vector<allocator_listener> listeners;
+
+    return listeners;
+}
+
+bool add_allocator_listener(allocator_listener f) {
+    allocator_listeners().push_back(f);
+
+    return true;
+}
+
+void set_allocator(allocator_kind k) {
+    s_state.release();
+    s_kind.store(k);
+    for ( const auto &it: allocator_listeners() ) {
+        it(k);
+    }
+}
+
+allocator_kind current_allocator() {
+    return s_kind.load(std::memory_order_relaxed);
+}
+
+void* harness_malloc(std::size_t size) {
+    switch ( current_allocator() ) {
+        case allocator_kind::arena: return s_state.arena_malloc(size);
+        case allocator_kind::pool: return s_state.pool_malloc(size);
+        case allocator_kind::freelist: return s_state.freelist_malloc(size);
+        default: return std::malloc(size);
+    }
+}
+
+void* harness_realloc(void *ptr, std::size_t old_size, std::size_t size) {
+    switch ( current_allocator() ) {
+        case allocator_kind::arena: return s_state.arena_realloc(ptr, old_size, size);
+        case allocator_kind::pool: return s_state.block_realloc(ptr, size, &thread_state::pool_malloc);
+        case allocator_kind::freelist: return s_state.block_realloc(ptr, size, &thread_state::freelist_malloc);
+        default: return std::realloc(ptr, size);
+    }
+}
+
+void harness_free(void *ptr) {
+    if ( !ptr ) {
+        return;
+    }
+
+    switch ( current_allocator() ) {
+        case allocator_kind::arena: break;
+        case allocator_kind::pool:
+        case allocator_kind::freelist: s_state.block_free(ptr); break;
+        default: std::free(ptr); break;
+    }
+}
+
+void reset_allocator() {
+    if ( current_allocator() == allocator_kind::arena ) {
+        s_state.arena_reset();
+    }
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,73 @@
+#ifndef JSON_BENCHMARKS_ALLOCATORS_HPP
+#define JSON_BENCHMARKS_ALLOCATORS_HPP
+
+#include <iosfwd>
+#include <new>
+#include <cstddef>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+enum class allocator_kind {
+     system   // malloc()/realloc()/free() as is
+    ,arena    // bump pointer, free() is a no-op, everything is released at once after the trial
+    ,pool     // fixed-size blocks carved from the large chunks, the bigger ones from malloc()
+    ,freelist // power-of-two size classes from malloc(), the freed blocks are cached per thread
+    ,count_   // must be the last
+};
+
+const char* allocator_kind_name(allocator_kind k);
+std::ostream& operator<< (std::ostream &os, allocator_kind k);
+
+// the allocator the adapters route the library allocations to.
+// the kind is process-wide, the state of the allocators is per thread.
+// must be changed only when no blocks allocated by the previous kind are alive,
+// the memory cached by the calling thread for the previous kind is released.
+void set_allocator(allocator_kind k);
+allocator_kind current_allocator();
+
+// is called by set_allocator() with the new kind, for the libraries whose
+// allocation hooks are process-wide, so they are switched once and not by each thread.
+// the listeners are added during the static initialization, returns true
+using allocator_listener = void(*)(allocator_kind k);
+bool add_allocator_listener(allocator_listener f);
+
+// all the blocks are aligned to 16 bytes
+void* harness_malloc(std::size_t size);
+void* harness_realloc(void *ptr, std::size_t old_size, std::size_t size);
+void  harness_free(void *ptr);
+
+// is called after the document is freed, rewinds the arena of the calling thread
+// and keeps its chunks for the next trial. no-op for the other kinds.
+void reset_allocator();
+
+// the stateless std-compatible allocator over the harness allocator,
+// for the libraries parameterized by the allocator type
+template<typename T>
+struct harness_std_allocator {
+    using value_type = T;
+
+    harness_std_allocator() noexcept = default;
+    template<typename U>
+    harness_std_allocator(const harness_std_allocator<U> &) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if ( void *p = harness_malloc(n * sizeof(T)) ) {
+            return static_cast<T *>(p);
+        }
+        throw std::bad_alloc{};
+    }
+    void deallocate(T *p, std::size_t) noexcept { harness_free(p); }
+
+    template<typename U>
+    bool operator== (const harness_std_allocator<U> &) const noexcept { return true; }
+    template<typename U>
+    bool operator!= (const harness_std_allocator<U> &) const noexcept { return false; }
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_ALLOCATORS_HPP
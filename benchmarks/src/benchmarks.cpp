@@ -1,8 +1,14 @@
 
 #include "benchmarks.hpp"
 
-#include <chrono>
 #include <sstream>
+#include <ostream>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+
+#include "timer.hpp"
+#include "mmfile.hpp"
 
 #include "tests/jsoncons.hpp"
 #include "tests/json11.hpp"
@@ -18,37 +24,41 @@
 
 namespace json_benchmarks {
 
-using std::chrono::high_resolution_clock;
-using std::chrono::duration;
-
 /*************************************************************************************************/
 
 std::pair<bool, std::string>
 benchmarks::check(io_device *in, io_device *out, std::size_t flags) const {
-    assert(in->type() == io_type::string_buffer || in->type() == io_type::mmap_streams);
-    assert(out->type() == io_type::string_buffer || out->type() == io_type::std_strstreams);
-
-    const char *srcptr = nullptr;
-    std::size_t srcsize= 0;
-    if ( in->type() == io_type::string_buffer ) {
-        const auto &string = static_cast<input_string_buffer_io *>(in)->stream();
-        srcptr = string.data();
-        srcsize= string.length();
-    } else {
-        const auto pair = static_cast<input_mmap_stream_io *>(in)->stream();
-        srcptr = pair.first;
-        srcsize= pair.second;
-    }
+    const auto src = in->read_all();
+    const char *srcptr = src.first;
+    std::size_t srcsize= src.second;
 
     std::string dststring;
-    if ( out->type() == io_type::string_buffer ) {
-        auto &string = static_cast<output_string_buffer_io *>(out)->stream();
-        dststring = std::move(string);
-    } else {
-        auto &stringstream = static_cast<output_std_strstream_io *>(out)->stream();
-        auto wr = stringstream.tellp();
-        dststring = std::move(stringstream.str());
-        dststring.resize(wr);
+    switch ( out->type() ) {
+        case io_type::string_buffer: {
+            auto &string = static_cast<output_string_buffer_io *>(out)->stream();
+            dststring = std::move(string);
+            break;
+        }
+        case io_type::std_strstreams: {
+            auto &stringstream = static_cast<output_std_strstream_io *>(out)->stream();
+            auto wr = stringstream.tellp();
+            dststring = std::move(stringstream.str());
+            dststring.resize(wr);
+            break;
+        }
+        default: {
+            // the file devices, the written bytes are read back from the file
+            if ( out->type() == io_type::std_fstreams ) {
+                static_cast<output_std_fstream_io *>(out)->stream().flush();
+            } else if ( out->type() == io_type::stdio_streams ) {
+                std::fflush(static_cast<output_stdio_stream_io *>(out)->stream());
+            }
+
+            auto written = json_benchmarks::create_io(io_direction::input, io_type::fd_streams, out->name());
+            const auto bytes = written->read_all();
+            dststring.assign(bytes.first, std::min(bytes.second, out->size()));
+            break;
+        }
     }
 
     auto *os = std::fopen("test-output.json", "wb");
@@ -83,6 +93,84 @@ benchmarks::check(io_device *in, io_device *out, std::size_t flags) const {
 std::pair<std::size_t, std::size_t>
 benchmarks::allowed_leaks() const { return {0, 0};}
 
+benchmarks::benchmarks()
+    :m_suffix{}
+    ,m_options{}
+    ,m_required{}
+{}
+
+/*************************************************************************************************/
+
+bool benchmarks::supports_allocator(allocator_kind k) const { return k == allocator_kind::system; }
+
+bool benchmarks::supports_reuse() const { return false; }
+
+void benchmarks::release() const {}
+
+bool benchmarks::retains_storage(std::size_t flags) const { return (flags & e_json_flags::reuse) != 0; }
+
+bool benchmarks::supports_sax() const { return false; }
+
+std::pair<bool, std::string>
+benchmarks::sax_parse(io_device */*in*/, std::size_t /*flags*/, sax_totals */*totals*/)
+{ return {false, "the SAX parse is not supported"}; }
+
+bool benchmarks::supports_chunks() const { return false; }
+
+void benchmarks::begin_chunks(std::size_t /*flags*/) {}
+
+std::pair<bool, std::string>
+benchmarks::parse_chunk(const char */*ptr*/, std::size_t /*size*/)
+{ return {false, "the chunked parse is not supported"}; }
+
+std::pair<bool, std::string>
+benchmarks::finish_chunks()
+{ return {false, "the chunked parse is not supported"}; }
+
+bool benchmarks::supports_records() const { return false; }
+
+void benchmarks::prepare_records(io_device */*in*/, std::size_t /*flags*/) {}
+
+std::pair<bool, std::string>
+benchmarks::parse_records(io_device */*in*/, std::size_t /*flags*/, record_ticks */*ticks*/)
+{ return {false, "the batch parse of the records is not supported"}; }
+
+void benchmarks::finish_records() {}
+
+bool benchmarks::supports_traverse() const { return false; }
+
+std::pair<bool, std::string>
+benchmarks::traverse(traverse_pattern /*p*/, traverse_totals */*totals*/)
+{ return {false, "the traverse is not supported"}; }
+
+const char* traverse_pattern_name(traverse_pattern p) {
+    switch ( p ) {
+        case traverse_pattern::dfs: return "dfs";
+        case traverse_pattern::lookup: return "lookup";
+        case traverse_pattern::arrays: return "arrays";
+        case traverse_pattern::random: return "random";
+        case traverse_pattern::count_: break;
+    }
+
+    return "UNKNOWN";
+}
+
+// splitmix64, so the sequence doesn't depend on the standard library
+std::size_t random_index(std::size_t i, std::size_t size) {
+    std::uint64_t z = (i + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z = z ^ (z >> 31);
+
+    return size ? static_cast<std::size_t>(z % size) : 0;
+}
+
+void record_ticks::tick() {
+    if ( count < capacity ) {
+        ticks[count++] = phase_timer::now();
+    }
+}
+
 /*************************************************************************************************/
 
 std::pair<
@@ -96,41 +184,98 @@ benchmarks::create_io(const std::string &input_fname) const {
     };
 }
 
+std::pair<
+     std::unique_ptr<io_device>
+    ,std::unique_ptr<io_device>
+>
+benchmarks::create_io(const std::string &input_fname, io_type input_io, io_type output_io) const {
+    const bool to_file = output_io != io_type::string_buffer && output_io != io_type::std_strstreams;
+
+    return {
+         json_benchmarks::create_io(io_direction::input, input_io, input_fname)
+        ,json_benchmarks::create_io(io_direction::output, output_io, to_file ? input_fname + ".out" : "")
+    };
+}
+
+std::vector<io_type> benchmarks::input_io_types() const { return {input_io_type()}; }
+
+std::vector<io_type> benchmarks::output_io_types() const { return {output_io_type()}; }
+
 /*************************************************************************************************/
 
-std::size_t benchmarks::start_time() {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(
-        high_resolution_clock::now().time_since_epoch()
-    ).count();
+std::uint64_t benchmarks::start_time() {
+    return phase_timer::now();
 }
 
-std::size_t benchmarks::duration(std::size_t start) {
-    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-        high_resolution_clock::now().time_since_epoch()
-    ).count();
-    return now - start;
+std::uint64_t benchmarks::duration(std::uint64_t start) {
+    return phase_timer::elapsed_ns(start);
 }
 
 /*************************************************************************************************/
 
+std::string benchmarks::variant_name() const {
+    return m_suffix.empty() ? std::string{name()} : std::string{name()} + "-" + m_suffix;
+}
+
+void benchmarks::set_variant(const char *suffix, std::size_t options, std::size_t required) {
+    m_suffix = suffix;
+    m_options = options;
+    m_required = required;
+}
+
+/*************************************************************************************************/
+
+std::size_t count_json_values(const std::string &input_fname) {
+    mmsource src{input_fname.c_str()};
+
+    auto parser = flatjson::make_parser(src.begin(), src.end());
+    std::size_t toknum = flatjson::parse(&parser);
+    if ( !flatjson::is_valid(&parser) ) {
+        toknum = 0;
+    }
+    flatjson::free_parser(&parser);
+
+    return toknum;
+}
+
+/*************************************************************************************************/
+
+template<typename T>
+void add_variant(benchmarks_list *list, const char *suffix = "", std::size_t options = 0, std::size_t required = 0) {
+    auto impl = std::make_unique<T>();
+    impl->set_variant(suffix, options, required);
+    list->emplace_back(std::move(impl));
+}
+
 benchmarks_list create_benchmarks() {
     benchmarks_list list;
 
-    list.emplace_back(std::make_unique<jsoncons_benchmarks>());
-    list.emplace_back(std::make_unique<flatjson_benchmarks>());
-    list.emplace_back(std::make_unique<flatjson_benchmarks>());
-    list.emplace_back(std::make_unique<yyjson_benchmarks>());
-    list.emplace_back(std::make_unique<yyjson_benchmarks>());
-    list.emplace_back(std::make_unique<simdjson_benchmarks>());
-    list.emplace_back(std::make_unique<simdjson_benchmarks>());
+    add_variant<jsoncons_benchmarks>(&list);
+    add_variant<flatjson_benchmarks>(&list);
+    add_variant<flatjson_benchmarks>(&list, "despaced", flatjson_options::despaced, e_json_flags::despaced);
+    add_variant<yyjson_benchmarks>(&list);
+    add_variant<yyjson_benchmarks>(&list, "insitu", yyjson_options::insitu);
+    add_variant<simdjson_benchmarks>(&list);
+    add_variant<simdjson_benchmarks>(&list, "dom-reuse", e_json_flags::reuse);
 //    list.emplace_back(std::make_unique<json11_benchmarks>());
 //    list.emplace_back(std::make_unique<taojson_benchmarks>());
-//    list.emplace_back(std::make_unique<cjson_benchmarks>());
-//    list.emplace_back(std::make_unique<jsoncpp_benchmarks>());
+    add_variant<cjson_benchmarks>(&list);
+    add_variant<jsoncpp_benchmarks>(&list);
 
     return list;
 }
 
+void write_libraries_info(std::ostream &os, const benchmarks_list &list) {
+    os << "Library|Version" << std::endl;
+    os << "---|---" << std::endl;
+    std::set<std::string> written;
+    for ( const auto &it: list ) {
+        if ( written.insert(it->name()).second ) {
+            os << "[" << it->name() << "](" << it->url() << ")" << "|" << it->version() << std::endl;
+        }
+    }
+}
+
 /*************************************************************************************************/
 
 } // json_benchmarks
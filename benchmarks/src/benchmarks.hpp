@@ -4,8 +4,13 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+#include <cstring>
 
 #include "io_device.hpp"
+#include "allocators.hpp"
 
 namespace json_benchmarks {
 
@@ -14,12 +19,78 @@ namespace json_benchmarks {
 struct e_json_flags {
     enum {
         despaced = 1u << 0
+       ,reuse    = 1u << 1 // keep the parser/document storage across the trials, see supports_reuse()
+       // the bits starting from this one are the options of the particular library,
+       // see the *_options of the adapters and the variants in create_benchmarks()
+       ,library_options = 1u << 8
     };
 };
 
 /*************************************************************************************************/
 
+// collected by the SAX visitors of the adapters, so the handlers can't be optimized out
+// and the libraries can be cross-checked against each other
+struct sax_totals {
+    std::size_t events;  // the begin/end of the objects and the arrays, the keys and the scalar values
+    double numbers;      // the sum of all the numbers
+};
+
+// the access patterns of the traverse phase, see benchmarks::traverse().
+// the document is expected to be the top-level array of the 'person' objects, see data_generator.hpp
+enum class traverse_pattern {
+     dfs    // every value of the document, depth-first
+    ,lookup // 'person.favorites.color' of each element of the top-level array
+    ,arrays // the 'integer_values' and 'double_values' of the elements having them
+    ,random // 'person.salary' of the elements at the random_index() positions
+    ,count_ // must be the last
+};
+
+const char* traverse_pattern_name(traverse_pattern p);
+
+// collected by the adapters while reading the DOM, so the reads can't be optimized out
+// and the libraries can be cross-checked against each other
+struct traverse_totals {
+    std::size_t values;  // the visited values, the keys are not counted
+    std::size_t strings; // the sum of the lengths of the strings and the keys
+    double numbers;      // the sum of all the numbers
+};
+
+// the number of the accesses of traverse_pattern::random
+constexpr std::size_t traverse_random_accesses = 1000;
+
+// the pseudo-random index of the i-th access, the same sequence for all the libraries
+std::size_t random_index(std::size_t i, std::size_t size);
+
+// the timer ticks taken by the adapters after each record of the batch parse.
+// the storage is reserved by the harness, so tick() never allocates
+struct record_ticks {
+    std::uint64_t *ticks;
+    std::size_t capacity;
+    std::size_t count;
+
+    void tick();
+};
+
+// calls 'f(ptr, size)' for each non-empty line of the newline-delimited input
+template<typename F>
+void for_each_record(const char *ptr, std::size_t size, F &&f) {
+    const char *end = ptr + size;
+    while ( ptr < end ) {
+        const auto *nl = static_cast<const char *>(std::memchr(ptr, '\n', end - ptr));
+        const auto *eol = nl ? nl : end;
+        if ( eol != ptr ) {
+            if ( !f(ptr, static_cast<std::size_t>(eol - ptr)) ) {
+                return;
+            }
+        }
+        ptr = eol + 1;
+    }
+}
+
+/*************************************************************************************************/
+
 struct benchmarks {
+    benchmarks();
     virtual ~benchmarks() = default;
     // used to allocate the root object, to warmup input data, count a tokens, etc...
     // pointer/object ot that type should be accessed inside the CPP file only.
@@ -38,10 +109,56 @@ struct benchmarks {
         ,std::size_t // in allocations
     > allowed_leaks() const;
 
+    // the libraries which accept the user allocator route it to the harness one, see allocators.hpp.
+    // the others are measured with the system allocator only.
+    virtual bool supports_allocator(allocator_kind k) const;
+
+    // in the reuse mode the storage allocated by the first prepare()/parse() is kept by finish()
+    // and reparsed into by the next trials, as the long-lived workers do.
+    // release() frees it after the last trial.
+    virtual bool supports_reuse() const;
+    virtual void release() const;
+    // the storage the first trial keeps for the next ones with these flags,
+    // is not reported as the leak. by default the one of the reuse mode
+    virtual bool retains_storage(std::size_t flags) const;
+
+    // the event-driven parse of the whole input without building the DOM.
+    // is measured apart from the prepare/parse/print/finish trials.
+    virtual bool supports_sax() const;
+    virtual std::pair<bool, std::string> sax_parse(io_device *in, std::size_t flags, sax_totals *totals);
+
+    // the incremental parse of the input fed in the chunks, as the network bodies arrive.
+    // begin_chunks() starts the document and is timed with the chunks, as the whole-buffer parse
+    // constructs its parser too. parse_chunk() is called for each chunk in order,
+    // finish_chunks() completes the document, which is freed by finish() as the one of parse()
+    virtual bool supports_chunks() const;
+    virtual void begin_chunks(std::size_t flags);
+    virtual std::pair<bool, std::string> parse_chunk(const char *ptr, std::size_t size);
+    virtual std::pair<bool, std::string> finish_chunks();
+
+    // the batch parse of the newline-delimited records, see e_data_generator_mode::ndjson.
+    // prepare_records() is not timed. parse_records() parses all the records, the document
+    // of each one is freed before the next, and calls ticks->tick() after each record.
+    // finish_records() frees what is kept across the records and the trials
+    virtual bool supports_records() const;
+    virtual void prepare_records(io_device *in, std::size_t flags);
+    virtual std::pair<bool, std::string> parse_records(io_device *in, std::size_t flags, record_ticks *ticks);
+    virtual void finish_records();
+
+    // the reads of the document built by parse(), with each of the traverse_pattern's.
+    // is called between parse() and finish() of the separate trials, only the traverse is timed
+    virtual bool supports_traverse() const;
+    virtual std::pair<bool, std::string> traverse(traverse_pattern p, traverse_totals *totals);
+
 //    virtual test_suite_results run_test_suite(const test_suite_files &pathnames) = 0;
 
+    // the default devices, are used when the I/O matrix is not requested
     virtual io_type input_io_type() const = 0;
     virtual io_type output_io_type() const = 0;
+    // all the devices the library can consume/produce, used by the I/O matrix.
+    // by default the single one of the above
+    virtual std::vector<io_type> input_io_types() const;
+    virtual std::vector<io_type> output_io_types() const;
 
     virtual const char* name() const = 0;
     virtual const char* url() const = 0;
@@ -50,16 +167,43 @@ struct benchmarks {
 
     std::pair<std::unique_ptr<io_device>, std::unique_ptr<io_device>>
     create_io(const std::string &input_fname) const;
-
-    std::size_t start_time();
-    std::size_t duration(std::size_t start);
+    // the file-based output devices write into '<input_fname>.out'
+    std::pair<std::unique_ptr<io_device>, std::unique_ptr<io_device>>
+    create_io(const std::string &input_fname, io_type input_io, io_type output_io) const;
+
+    // raw ticks of the phase timer, see timer.hpp
+    std::uint64_t start_time();
+    // nanoseconds elapsed since 'start', the timer overhead is subtracted
+    std::uint64_t duration(std::uint64_t start);
+
+    // the library with a set of its options is the variant, each one is the separate row of the reports.
+    // the name of the row, "<name()>-<suffix>" or name() for the default variant
+    std::string variant_name() const;
+    // OR-ed into the flags passed to prepare/parse/print
+    std::size_t options() const { return m_options; }
+    // false when the variant needs the flags the harness doesn't pass, e.g. the despaced input
+    bool applicable(std::size_t flags) const { return (flags & m_required) == m_required; }
+    void set_variant(const char *suffix, std::size_t options, std::size_t required);
+
+private:
+    std::string m_suffix;
+    std::size_t m_options;
+    std::size_t m_required;
 };
 
 using benchmarks_ptr  = std::unique_ptr<benchmarks>;
 using benchmarks_list = std::vector<benchmarks_ptr>;
 
+// the registry of the variants
 benchmarks_list create_benchmarks();
 
+// the '[name](url)|version' rows of the libraries, once for all the variants of a library
+void write_libraries_info(std::ostream &os, const benchmarks_list &list);
+
+// the number of JSON values (tokens) in the file, counted by a single flatjson pass.
+// zero if the file is not a valid JSON.
+std::size_t count_json_values(const std::string &input_fname);
+
 /*************************************************************************************************/
 #if 0
 struct json_spirit_benchmarks: benchmarks {
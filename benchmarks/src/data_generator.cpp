@@ -13,6 +13,41 @@ using std::chrono::duration;
 
 /*************************************************************************************************/
 
+// one compact record per line, as the log shippers write them
+static void make_ndjson_records(std::ostream &os, std::mt19937_64 &rng, std::size_t records) {
+    static const char *levels[] = {"debug", "info", "info", "info", "warn", "error"};
+    static const char *methods[] = {"GET", "GET", "POST", "PUT", "DELETE"};
+    static const char *services[] = {"api-gateway", "auth", "billing", "search", "storage"};
+    static const int statuses[] = {200, 200, 200, 201, 204, 304, 400, 404, 500, 503};
+
+    std::uniform_int_distribution<std::uint64_t> pick{0, 1000000};
+    std::uniform_real_distribution<double> latency{0.1, 250.0};
+    std::uint64_t ts = 1700000000000ull;
+    for ( std::size_t i = 0; i < records; ++i ) {
+        ts += pick(rng) % 10;
+        const auto user = pick(rng);
+        const auto status = statuses[pick(rng) % (sizeof(statuses) / sizeof(statuses[0]))];
+        os
+            << "{\"ts\":" << ts
+            << ",\"level\":\"" << levels[pick(rng) % (sizeof(levels) / sizeof(levels[0]))] << "\""
+            << ",\"service\":\"" << services[pick(rng) % (sizeof(services) / sizeof(services[0]))] << "\""
+            << ",\"host\":\"node-" << (pick(rng) % 64) << "\""
+            << ",\"request_id\":\"" << std::hex << rng() << std::dec << "\""
+            << ",\"method\":\"" << methods[pick(rng) % (sizeof(methods) / sizeof(methods[0]))] << "\""
+            << ",\"path\":\"/v1/users/" << user << "/orders\""
+            << ",\"status\":" << status
+            << ",\"latency_ms\":" << latency(rng)
+            << ",\"bytes\":" << (pick(rng) % 65536)
+            << ",\"user\":{\"id\":" << user
+                << ",\"ip\":\"10." << (user % 256) << "." << (user / 256 % 256) << "." << (user / 65536 % 256) << "\""
+                << ",\"authenticated\":" << (user % 3 ? "true" : "false") << "}"
+            << ",\"tags\":[\"http\",\"" << (status >= 500 ? "alert" : "edge") << "\"]"
+            << ",\"error\":" << (status >= 500 ? "\"upstream timeout\"" : "null")
+            << "}\n"
+        ;
+    }
+}
+
 std::size_t make_test_file(
      const std::string &filename
     ,std::size_t repeats
@@ -32,6 +67,15 @@ std::size_t make_test_file(
     std::random_device rd;
     std::mt19937_64 rng(rd());
 
+    if ( flags & static_cast<std::size_t>(e_data_generator_mode::ndjson) ) {
+        auto start = high_resolution_clock::now();
+        make_ndjson_records(os, rng, repeats);
+        os.flush();
+        auto end = high_resolution_clock::now();
+
+        return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
     jsoncons::json_options options;
     options.escape_all_non_ascii(true);
     jsoncons::json_stream_encoder pretyfied_handler(os, options);
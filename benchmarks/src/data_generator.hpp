@@ -17,6 +17,7 @@ struct e_data_generator_mode {
         ,mixed     = 1u << 4
         ,smallfile = 1u << 5
         ,compacted = 1u << 6 // OR`ed
+        ,ndjson    = 1u << 7 // the newline-delimited log records, 'repeats' is the number of them
     };
 };
 
@@ -29,6 +30,7 @@ static constexpr const char *s_data_generator_mode[] = {
     ,"mixed"
     ,"smallfile"
     ,"compacted"
+    ,"ndjson"
 };
 
 inline std::ostream& operator<< (std::ostream &os, e_data_generator_mode::k_e v) {
@@ -40,6 +42,7 @@ inline std::ostream& operator<< (std::ostream &os, e_data_generator_mode::k_e v)
         case e_data_generator_mode::mixed: return os << s_data_generator_mode[4];
         case e_data_generator_mode::smallfile: return os << s_data_generator_mode[5];
         case e_data_generator_mode::compacted: return os << s_data_generator_mode[6];
+        case e_data_generator_mode::ndjson: return os << s_data_generator_mode[7];
     }
 
     return os;
@@ -0,0 +1,128 @@
+
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+unsigned bit_length(std::uint64_t v) {
+    unsigned res = 0;
+    for ( ; v; v >>= 1 ) {
+        ++res;
+    }
+
+    return res;
+}
+
+} // anon ns
+
+hdr_histogram::hdr_histogram(std::uint64_t highest, int significant_digits)
+    :m_sub_bucket_half_count_magnitude{}
+    ,m_sub_bucket_half_count{}
+    ,m_sub_bucket_mask{}
+    ,m_counts{}
+    ,m_count{}
+    ,m_min{std::numeric_limits<std::uint64_t>::max()}
+    ,m_max{}
+    ,m_total{}
+{
+    // the values below this one are kept exactly
+    const auto single_unit_resolution = 2 * static_cast<std::uint64_t>(std::pow(10, significant_digits));
+    const auto sub_bucket_count_magnitude = bit_length(single_unit_resolution - 1);
+    m_sub_bucket_half_count_magnitude = sub_bucket_count_magnitude - 1;
+    m_sub_bucket_half_count = 1ull << m_sub_bucket_half_count_magnitude;
+    m_sub_bucket_mask = (1ull << sub_bucket_count_magnitude) - 1;
+
+    // each next bucket covers the twice wider range with the same number of the sub-buckets
+    std::size_t buckets = 1;
+    for ( auto range = 1ull << sub_bucket_count_magnitude; range <= highest && range < (1ull << 62); range <<= 1 ) {
+        ++buckets;
+    }
+    m_counts.resize((buckets + 1) * m_sub_bucket_half_count);
+}
+
+std::size_t hdr_histogram::index_of(std::uint64_t v) const {
+    const auto bucket = bit_length(v | m_sub_bucket_mask) - (m_sub_bucket_half_count_magnitude + 1);
+    const auto sub_bucket = v >> bucket;
+    const auto index = ((static_cast<std::size_t>(bucket) + 1) << m_sub_bucket_half_count_magnitude)
+        + (sub_bucket - m_sub_bucket_half_count);
+
+    return std::min(index, m_counts.size() - 1);
+}
+
+std::uint64_t hdr_histogram::highest_equivalent(std::size_t index) const {
+    long bucket = static_cast<long>(index >> m_sub_bucket_half_count_magnitude) - 1;
+    auto sub_bucket = (index & (m_sub_bucket_half_count - 1)) + m_sub_bucket_half_count;
+    if ( bucket < 0 ) {
+        sub_bucket -= m_sub_bucket_half_count;
+        bucket = 0;
+    }
+
+    return (sub_bucket << bucket) + (1ull << bucket) - 1;
+}
+
+void hdr_histogram::record(std::uint64_t v) {
+    ++m_counts[index_of(v)];
+    ++m_count;
+    m_min = std::min(m_min, v);
+    m_max = std::max(m_max, v);
+    m_total += v;
+}
+
+double hdr_histogram::mean() const {
+    return m_count ? static_cast<double>(m_total / m_count) : 0.0;
+}
+
+std::uint64_t hdr_histogram::value_at_percentile(double p) const {
+    if ( !m_count ) {
+        return 0;
+    }
+    if ( p >= 100.0 ) {
+        return m_max;
+    }
+
+    const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * m_count)));
+    std::uint64_t seen = 0;
+    for ( auto i = 0u; i < m_counts.size(); ++i ) {
+        seen += m_counts[i];
+        if ( seen >= target ) {
+            return std::min(highest_equivalent(i), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+hdr_histogram& hdr_histogram::operator+= (const hdr_histogram &r) {
+    for ( auto i = 0u; i < m_counts.size() && i < r.m_counts.size(); ++i ) {
+        m_counts[i] += r.m_counts[i];
+    }
+    m_count += r.m_count;
+    m_min = std::min(m_min, r.m_min);
+    m_max = std::max(m_max, r.m_max);
+    m_total += r.m_total;
+
+    return *this;
+}
+
+std::ostream& operator<< (std::ostream &os, const hdr_histogram &h) {
+    return os
+        << "count: " << h.count()
+        << ", min: " << h.min()
+        << ", p50: " << h.value_at_percentile(50.0)
+        << ", p99: " << h.value_at_percentile(99.0)
+        << ", p99.9: " << h.value_at_percentile(99.9)
+        << ", max: " << h.max()
+    ;
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,66 @@
+#ifndef JSON_BENCHMARKS_HDR_HISTOGRAM_HPP
+#define JSON_BENCHMARKS_HDR_HISTOGRAM_HPP
+
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+// the log-linear histogram in the spirit of HdrHistogram.
+// every value in [1 .. 'highest'] is kept with 'significant_digits' decimal digits
+// of precision, so the tail percentiles are as accurate as the median.
+// recording is an index calculation and an increment, it never allocates.
+struct hdr_histogram {
+    explicit hdr_histogram(std::uint64_t highest = 3600000000000ull, int significant_digits = 3);
+
+    // the values above 'highest' are counted in the last bucket, max() stays exact
+    void record(std::uint64_t v);
+
+    std::uint64_t count() const { return m_count; }
+    std::uint64_t min() const { return m_count ? m_min : 0; }
+    std::uint64_t max() const { return m_max; }
+    double mean() const;
+    // 'p' is in 0..100, the highest value equivalent to the one at the percentile
+    std::uint64_t value_at_percentile(double p) const;
+
+    // both must be created with the same parameters
+    hdr_histogram& operator+= (const hdr_histogram &r);
+
+    // "count: 100, min: 1, p50: 2, p99: 3, p99.9: 4, max: 5"
+    friend std::ostream& operator<< (std::ostream &os, const hdr_histogram &h);
+
+    // the recorded state for the transfer between the processes, see ipc.hpp.
+    // both sides must be created with the same parameters
+    template<typename Archive, typename H>
+    static void transfer(Archive &ar, H &h) {
+        ar
+            & h.m_counts
+            & h.m_count
+            & h.m_min
+            & h.m_max
+            & h.m_total
+        ;
+    }
+
+private:
+    std::size_t index_of(std::uint64_t v) const;
+    std::uint64_t highest_equivalent(std::size_t index) const;
+
+    unsigned m_sub_bucket_half_count_magnitude;
+    std::uint64_t m_sub_bucket_half_count;
+    std::uint64_t m_sub_bucket_mask;
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_count;
+    std::uint64_t m_min;
+    std::uint64_t m_max;
+    long double m_total;
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_HDR_HISTOGRAM_HPP
@@ -0,0 +1,307 @@
+
+#include "history.hpp"
+#include "benchmarks.hpp"
+#include "os_tools.hpp"
+#include "mmfile.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include "jsoncons/json.hpp"
+
+#ifdef WIN32
+#   define popen _popen
+#   define pclose _pclose
+#   define DEV_NULL "NUL"
+#else
+#   define DEV_NULL "/dev/null"
+#endif
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+std::uint64_t fnv1a(const char *ptr, std::size_t size, std::uint64_t hash = 14695981039346656037ull) {
+    for ( const auto *end = ptr + size; ptr != end; ++ptr ) {
+        hash = (hash ^ static_cast<unsigned char>(*ptr)) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::string to_hex(std::uint64_t v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+
+    return buf;
+}
+
+// the stdout of the command, without the trailing new line
+std::string run_command(const char *cmd) {
+    FILE *pipe = ::popen(cmd, "r");
+    if ( !pipe ) {
+        return std::string{};
+    }
+
+    std::string res;
+    char buf[256];
+    while ( std::fgets(buf, sizeof(buf), pipe) ) {
+        res += buf;
+    }
+    ::pclose(pipe);
+
+    while ( !res.empty() && (res.back() == '\n' || res.back() == '\r') ) {
+        res.pop_back();
+    }
+
+    return res;
+}
+
+} // anon ns
+
+std::string get_git_commit() {
+    auto commit = run_command("git rev-parse HEAD 2>" DEV_NULL);
+    if ( commit.empty() ) {
+        return commit;
+    }
+
+    auto changes = run_command("git status --porcelain --untracked-files=no 2>" DEV_NULL);
+
+    return changes.empty() ? commit : commit + "-dirty";
+}
+
+std::string get_machine_fingerprint() {
+    auto str = get_cpu() + "|" + get_ram() + "|" + get_os() + "|" + get_motherboard();
+
+    return to_hex(fnv1a(str.data(), str.size()));
+}
+
+std::string get_dataset_hash(const std::string &fname) {
+    mmsource src{fname.c_str()};
+
+    return to_hex(fnv1a(src.data(), src.size()));
+}
+
+const std::string& environment_value(const run_environment &env, const char *name) {
+    static const std::string empty;
+    auto it = std::find_if(env.begin(), env.end(), [name](const auto &p){ return p.first == name; });
+
+    return it != env.end() ? it->second : empty;
+}
+
+/*************************************************************************************************/
+
+std::pair<bool, std::string> append_history(
+     const std::string &fname
+    ,const run_environment &env
+    ,const benchmark_results &results)
+{
+    std::ofstream os{fname, std::ios::app};
+    if ( !os ) {
+        return {false, "can't open \"" + fname + "\": " + std::strerror(errno)};
+    }
+
+    for ( const auto &[impl, stat]: results ) {
+        jsoncons::json rec;
+        rec["date"] = environment_value(env, "date");
+        rec["commit"] = environment_value(env, "commit");
+        rec["machine"] = environment_value(env, "machine");
+        rec["dataset_hash"] = environment_value(env, "dataset_hash");
+        rec["suite"] = environment_value(env, "suite");
+        rec["compiler"] = environment_value(env, "compiler");
+        rec["library"] = stat.name;
+        rec["version"] = impl->version();
+        rec["parse_mbs"] = stat.parse_throughput();
+        rec["print_mbs"] = stat.print_throughput();
+        rec["parse_median_ns"] = stat.time_to_parse;
+        rec["print_median_ns"] = stat.time_to_print;
+        rec["parse_allocations"] = stat.parse_allocations;
+        rec["print_allocations"] = stat.print_allocations;
+
+        os << rec << std::endl;
+    }
+
+    return {os.good(), os.good() ? std::string{} : "can't write \"" + fname + "\""};
+}
+
+/*************************************************************************************************/
+
+namespace {
+
+struct trend_point {
+    std::size_t run;
+    double value;
+    std::string title;
+};
+
+// one run is the set of the records with the same date and commit
+struct trend_data {
+    std::vector<std::string> runs; // the X axis labels
+    std::map<std::string, std::vector<trend_point>> parse; // by library
+    std::map<std::string, std::vector<trend_point>> print;
+};
+
+std::string escape_xml(const std::string &str) {
+    std::string res;
+    for ( auto ch: str ) {
+        switch ( ch ) {
+            case '<': res += "&lt;"; break;
+            case '>': res += "&gt;"; break;
+            case '&': res += "&amp;"; break;
+            case '"': res += "&quot;"; break;
+            default: res += ch;
+        }
+    }
+
+    return res;
+}
+
+void write_svg_chart(
+     std::ostream &os
+    ,const char *caption
+    ,const std::vector<std::string> &runs
+    ,const std::map<std::string, std::vector<trend_point>> &series)
+{
+    static const char *palette[] = {
+        "#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd",
+        "#8c564b", "#e377c2", "#7f7f7f", "#bcbd22", "#17becf"
+    };
+    static const int width = 960, height = 420;
+    static const int left = 60, right = 200, top = 30, bottom = 90;
+    const int plot_w = width - left - right;
+    const int plot_h = height - top - bottom;
+
+    double max_value = 0.0;
+    for ( const auto &it: series ) {
+        for ( const auto &p: it.second ) {
+            max_value = std::max(max_value, p.value);
+        }
+    }
+    max_value = max_value > 0.0 ? max_value * 1.1 : 1.0;
+
+    auto x = [&](std::size_t run) {
+        return left + (runs.size() > 1 ? plot_w * static_cast<double>(run) / (runs.size() - 1) : plot_w / 2.0);
+    };
+    auto y = [&](double value) {
+        return top + plot_h * (1.0 - value / max_value);
+    };
+
+    os << "<h2>" << caption << "</h2>" << std::endl;
+    os << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+       << "\" font-family=\"sans-serif\" font-size=\"11\">" << std::endl;
+
+    // the axes and the horizontal grid
+    for ( auto i = 0; i <= 5; ++i ) {
+        const double value = max_value * i / 5;
+        os << "<line x1=\"" << left << "\" y1=\"" << y(value) << "\" x2=\"" << (left + plot_w)
+           << "\" y2=\"" << y(value) << "\" stroke=\"#ddd\"/>" << std::endl;
+        os << "<text x=\"" << (left - 6) << "\" y=\"" << (y(value) + 4) << "\" text-anchor=\"end\">"
+           << static_cast<long long>(value) << "</text>" << std::endl;
+    }
+    os << "<text x=\"12\" y=\"" << (top + plot_h / 2) << "\" transform=\"rotate(-90 12 " << (top + plot_h / 2)
+       << ")\" text-anchor=\"middle\">MB/s</text>" << std::endl;
+
+    // too many labels overlap
+    const std::size_t label_step = std::max<std::size_t>(1, runs.size() / 20);
+    for ( auto i = 0u; i < runs.size(); i += label_step ) {
+        os << "<text x=\"" << x(i) << "\" y=\"" << (top + plot_h + 12) << "\" transform=\"rotate(45 " << x(i)
+           << " " << (top + plot_h + 12) << ")\">" << escape_xml(runs[i]) << "</text>" << std::endl;
+    }
+
+    std::size_t color = 0;
+    for ( const auto &[library, points]: series ) {
+        const char *stroke = palette[color++ % (sizeof(palette) / sizeof(palette[0]))];
+
+        os << "<polyline fill=\"none\" stroke=\"" << stroke << "\" stroke-width=\"2\" points=\"";
+        for ( const auto &p: points ) {
+            os << x(p.run) << "," << y(p.value) << " ";
+        }
+        os << "\"/>" << std::endl;
+        for ( const auto &p: points ) {
+            os << "<circle cx=\"" << x(p.run) << "\" cy=\"" << y(p.value) << "\" r=\"3\" fill=\"" << stroke
+               << "\"><title>" << escape_xml(p.title) << "</title></circle>" << std::endl;
+        }
+
+        const auto legend_y = top + 16 * static_cast<int>(color - 1);
+        os << "<rect x=\"" << (width - right + 16) << "\" y=\"" << (legend_y - 9) << "\" width=\"10\" height=\"10\" fill=\""
+           << stroke << "\"/>" << std::endl;
+        os << "<text x=\"" << (width - right + 32) << "\" y=\"" << legend_y << "\">" << escape_xml(library) << "</text>" << std::endl;
+    }
+
+    os << "</svg>" << std::endl;
+}
+
+} // anon ns
+
+std::pair<bool, std::string> write_trend_report(
+     const std::string &history_fname
+    ,const std::string &html_fname
+    ,const std::string &machine
+    ,const std::string &suite)
+{
+    std::ifstream is{history_fname};
+    if ( !is ) {
+        return {false, "can't open \"" + history_fname + "\": " + std::strerror(errno)};
+    }
+
+    trend_data data;
+    std::string last_run;
+    std::string line;
+    for ( std::size_t lineno = 1; std::getline(is, line); ++lineno ) {
+        if ( line.empty() ) {
+            continue;
+        }
+
+        jsoncons::json rec;
+        try {
+            rec = jsoncons::json::parse(line);
+        } catch (const std::exception &e) {
+            return {false, history_fname + ":" + std::to_string(lineno) + ": " + e.what()};
+        }
+        if ( rec.at("machine").as<std::string>() != machine || rec.at("suite").as<std::string>() != suite ) {
+            continue;
+        }
+
+        // the records of one run are adjacent because the file is append-only
+        const auto date = rec.at("date").as<std::string>();
+        const auto commit = rec.at("commit").as<std::string>();
+        const auto run = date + " " + commit.substr(0, 8);
+        if ( run != last_run ) {
+            data.runs.push_back(run);
+            last_run = run;
+        }
+
+        const auto library = rec.at("library").as<std::string>();
+        const auto title = library + " " + rec.at("version").as<std::string>() + ", " + run;
+        const auto parse_mbs = rec.at("parse_mbs").as<double>();
+        const auto print_mbs = rec.at("print_mbs").as<double>();
+        data.parse[library].push_back({data.runs.size() - 1, parse_mbs, title + ": " + std::to_string(parse_mbs) + " MB/s"});
+        data.print[library].push_back({data.runs.size() - 1, print_mbs, title + ": " + std::to_string(print_mbs) + " MB/s"});
+    }
+
+    std::ofstream os{html_fname};
+    if ( !os ) {
+        return {false, "can't create \"" + html_fname + "\": " + std::strerror(errno)};
+    }
+
+    os << "<!DOCTYPE html>" << std::endl;
+    os << "<html><head><meta charset=\"utf-8\"><title>" << escape_xml(suite) << " trend</title></head><body>" << std::endl;
+    os << "<h1>" << escape_xml(suite) << ": throughput over " << data.runs.size() << " runs</h1>" << std::endl;
+    os << "<p>machine " << escape_xml(machine) << ", the points show the library version and the commit</p>" << std::endl;
+    write_svg_chart(os, "Parse", data.runs, data.parse);
+    write_svg_chart(os, "Print", data.runs, data.print);
+    os << "</body></html>" << std::endl;
+
+    return {os.good(), os.good() ? std::string{} : "can't write \"" + html_fname + "\""};
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,43 @@
+#ifndef JSON_BENCHMARKS_HISTORY_HPP
+#define JSON_BENCHMARKS_HISTORY_HPP
+
+#include <string>
+#include <utility>
+
+#include "results.hpp"
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+// the keys of the history records.
+// the empty string when unknown.
+std::string get_git_commit(); // with the "-dirty" suffix when the tree has the local changes
+std::string get_machine_fingerprint();
+std::string get_dataset_hash(const std::string &fname);
+
+// the value of the 'name' in 'env', the empty string if there is no such
+const std::string& environment_value(const run_environment &env, const char *name);
+
+// appends one JSON line per library to 'fname', the file is never rewritten.
+// the keys are taken from 'env': date, commit, machine, dataset_hash, suite.
+std::pair<bool, std::string> append_history(
+     const std::string &fname
+    ,const run_environment &env
+    ,const benchmark_results &results
+);
+
+// the HTML page with the SVG charts of the parse and print throughput of each library
+// over the runs recorded in the history on the same 'machine' for the same 'suite'.
+std::pair<bool, std::string> write_trend_report(
+     const std::string &history_fname
+    ,const std::string &html_fname
+    ,const std::string &machine
+    ,const std::string &suite
+);
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_HISTORY_HPP
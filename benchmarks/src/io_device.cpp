@@ -3,6 +3,8 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <cerrno>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -17,6 +19,68 @@ namespace json_benchmarks {
 
 /*************************************************************************************************/
 
+std::pair<const char *, std::size_t> io_device::read_all() {
+    assert(direction() == io_direction::input && "read_all() of the output device");
+
+    return {nullptr, 0};
+}
+
+bool io_device::write_all(const char */*ptr*/, std::size_t /*size*/) {
+    assert(direction() == io_direction::output && "write_all() of the input device");
+
+    return false;
+}
+
+const char* io_type_name(io_type type) {
+    switch ( type ) {
+        case io_type::string_buffer: return "string_buffer";
+        case io_type::std_strstreams: return "std_strstreams";
+        case io_type::std_fstreams: return "std_fstreams";
+        case io_type::stdio_streams: return "stdio_streams";
+        case io_type::fd_streams: return "fd_streams";
+        case io_type::mmap_streams: return "mmap_streams";
+    }
+
+    return "UNKNOWN";
+}
+
+namespace {
+
+// reads the file from the beginning up to 'size' bytes, the short reads are retried
+std::size_t read_fd(int fd, char *ptr, std::size_t size) {
+    std::size_t done = 0;
+    while ( done < size ) {
+        auto rd = ::read(fd, ptr + done, size - done);
+        if ( rd <= 0 ) {
+            break;
+        }
+        done += static_cast<std::size_t>(rd);
+    }
+
+    return done;
+}
+
+// the short writes and the interrupted ones are retried
+bool write_fd(int fd, const char *ptr, std::size_t size) {
+    std::size_t done = 0;
+    while ( done < size ) {
+        auto wr = ::write(fd, ptr + done, size - done);
+        if ( wr < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( wr <= 0 ) {
+            return false;
+        }
+        done += static_cast<std::size_t>(wr);
+    }
+
+    return true;
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
 struct input_string_buffer_io::impl {
     impl(const std::string &input_fname)
         :ifname{input_fname}
@@ -50,6 +114,9 @@ std::size_t input_string_buffer_io::size() const { return pimpl->size(); }
 void input_string_buffer_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void input_string_buffer_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+std::pair<const char *, std::size_t> input_string_buffer_io::read_all()
+{ return {pimpl->istream.data(), pimpl->istream.size()}; }
+
 std::string& input_string_buffer_io::stream()
 { return pimpl->istream; }
 
@@ -81,11 +148,13 @@ std::size_t output_string_buffer_io::size() const { return pimpl->size(); }
 void output_string_buffer_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void output_string_buffer_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+bool output_string_buffer_io::write_all(const char *ptr, std::size_t size)
+{ pimpl->ostream.append(ptr, size); return true; }
+
 std::string& output_string_buffer_io::stream()
 { return pimpl->stream(); }
 
 /*************************************************************************************************/
-#if 0
 struct input_std_fstream_io::impl {
     impl(const std::string &input_fname)
         :ifname{input_fname}
@@ -99,11 +168,22 @@ struct input_std_fstream_io::impl {
 
         return istream;
     }
+    std::pair<const char *, std::size_t> read_all() {
+        buffer.resize(size());
+        istream.clear();
+        istream.seekg(0);
+        istream.read(buffer.data(), buffer.size());
+        buffer.resize(istream.gcount());
+
+        return {buffer.data(), buffer.size()};
+    }
     std::size_t size() { return file_size(ifname.c_str()); }
     void reserve(std::size_t /*size*/) {}
+    void resize(std::size_t /*size*/) {}
 
     std::string ifname;
     std::ifstream istream;
+    std::string buffer;
 };
 
 input_std_fstream_io::input_std_fstream_io(const std::string &input_fname)
@@ -112,10 +192,14 @@ input_std_fstream_io::input_std_fstream_io(const std::string &input_fname)
 
 io_type input_std_fstream_io::type() const { return io_type::std_fstreams; }
 io_direction input_std_fstream_io::direction() const { return io_direction::input; }
-void input_std_fstream_io::reset() { pimpl->istream.seekg(0); }
+void input_std_fstream_io::reset() { pimpl->istream.clear(); pimpl->istream.seekg(0); }
 const std::string& input_std_fstream_io::name() const { return pimpl->ifname; }
 std::size_t input_std_fstream_io::size() const { return pimpl->size(); }
 void input_std_fstream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void input_std_fstream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+std::pair<const char *, std::size_t> input_std_fstream_io::read_all()
+{ return pimpl->read_all(); }
 
 std::istream& input_std_fstream_io::stream()
 { return pimpl->stream(); }
@@ -132,16 +216,23 @@ struct output_std_fstream_io::impl {
     }
 
     std::ostream& stream() { return ostream; }
-    std::size_t size() { return file_size(ofname.c_str()); }
+    // the written bytes, not the size of the file which is preallocated by reserve()
+    std::size_t size() {
+        const auto pos = ostream.tellp();
+
+        return pos < 0 ? 0 : static_cast<std::size_t>(pos);
+    }
     void reserve(std::size_t size) {
         ostream.close();
 
-        assert(::truncate(ofname.c_str(), size) == 0);
+        const auto rc = ::truncate(ofname.c_str(), size);
+        assert(rc == 0);
+        (void)rc;
 
         ostream.open(ofname, mode);
         assert(ostream.is_open());
-        assert(file_size(ofname.c_str()) == size);
     }
+    void resize(std::size_t size) { return reserve(size); }
 
     std::string ofname;
     static constexpr std::fstream::openmode mode = std::ios::in|std::ios::out|std::ios::binary;
@@ -154,14 +245,17 @@ output_std_fstream_io::output_std_fstream_io(const std::string &output_fname)
 
 io_type output_std_fstream_io::type() const { return io_type::std_fstreams; }
 io_direction output_std_fstream_io::direction() const { return io_direction::output; }
-void output_std_fstream_io::reset() { pimpl->ostream.seekp(0); }
+void output_std_fstream_io::reset() { pimpl->ostream.clear(); pimpl->ostream.seekp(0); }
 const std::string& output_std_fstream_io::name() const { return pimpl->ofname; }
 std::size_t output_std_fstream_io::size() const { return pimpl->size(); }
 void output_std_fstream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void output_std_fstream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+bool output_std_fstream_io::write_all(const char *ptr, std::size_t size)
+{ return static_cast<bool>(pimpl->ostream.write(ptr, size)); }
 
 std::ostream& output_std_fstream_io::stream()
 { return pimpl->stream(); }
-#endif
 /*************************************************************************************************/
 
 struct input_std_strstream_io::impl {
@@ -186,6 +280,16 @@ struct input_std_strstream_io::impl {
         return istream;
     }
 
+    std::pair<const char *, std::size_t> read_all() {
+        buffer.resize(ibuffer.size());
+        istream.clear();
+        istream.seekg(0);
+        istream.read(buffer.data(), buffer.size());
+        buffer.resize(istream.gcount());
+
+        return {buffer.data(), buffer.size()};
+    }
+
     std::size_t size() { return ibuffer.size(); }
     void reserve(std::size_t size) { assert(size || "UNIMPLEMENTED!"); }
     void resize(std::size_t size) { assert(size || "UNIMPLEMENTED!"); }
@@ -193,6 +297,7 @@ struct input_std_strstream_io::impl {
     std::string ifname;
     std::string ibuffer;
     std::istringstream istream;
+    std::string buffer; // read_all() reads through the stream into it
 };
 
 input_std_strstream_io::input_std_strstream_io(const std::string &input_fname)
@@ -201,12 +306,15 @@ input_std_strstream_io::input_std_strstream_io(const std::string &input_fname)
 
 io_type input_std_strstream_io::type() const { return io_type::std_strstreams; }
 io_direction input_std_strstream_io::direction() const { return io_direction::input; }
-void input_std_strstream_io::reset() { pimpl->istream.seekg(0); }
+void input_std_strstream_io::reset() { pimpl->istream.clear(); pimpl->istream.seekg(0); }
 const std::string& input_std_strstream_io::name() const { return pimpl->ifname; }
 std::size_t input_std_strstream_io::size() const { return pimpl->size(); }
 void input_std_strstream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void input_std_strstream_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+std::pair<const char *, std::size_t> input_std_strstream_io::read_all()
+{ return pimpl->read_all(); }
+
 std::istream& input_std_strstream_io::stream()
 { return pimpl->stream(); }
 
@@ -242,11 +350,13 @@ std::size_t output_std_strstream_io::size() const { return pimpl->size(); }
 void output_std_strstream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void output_std_strstream_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+bool output_std_strstream_io::write_all(const char *ptr, std::size_t size)
+{ return static_cast<bool>(pimpl->ostream.write(ptr, size)); }
+
 std::ostringstream& output_std_strstream_io::stream()
 { return pimpl->ostream; }
 
 /*************************************************************************************************/
-#if 0
 struct input_stdio_stream_io::impl {
     impl(const std::string &input_fname)
         :ifname{input_fname}
@@ -263,12 +373,21 @@ struct input_stdio_stream_io::impl {
 
         return istream;
     }
-    void reset() { std::fseek(istream, SEEK_SET, 0); }
+    std::pair<const char *, std::size_t> read_all() {
+        buffer.resize(size());
+        std::fseek(istream, 0, SEEK_SET);
+        buffer.resize(std::fread(buffer.data(), 1, buffer.size(), istream));
+
+        return {buffer.data(), buffer.size()};
+    }
+    void reset() { std::fseek(istream, 0, SEEK_SET); }
     std::size_t size() { return file_size(ifname.c_str()); }
     void reserve(std::size_t /*size*/) {}
+    void resize(std::size_t /*size*/) {}
 
     std::string ifname;
     std::FILE *istream;
+    std::string buffer;
 };
 
 input_stdio_stream_io::input_stdio_stream_io(const std::string &input_fname)
@@ -281,6 +400,10 @@ void input_stdio_stream_io::reset() { return pimpl->reset(); }
 const std::string& input_stdio_stream_io::name() const { return pimpl->ifname; }
 std::size_t input_stdio_stream_io::size() const { return pimpl->size(); }
 void input_stdio_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void input_stdio_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+std::pair<const char *, std::size_t> input_stdio_stream_io::read_all()
+{ return pimpl->read_all(); }
 
 std::FILE* input_stdio_stream_io::stream()
 { return pimpl->stream(); }
@@ -292,16 +415,27 @@ struct output_stdio_stream_io::impl {
         :ofname{output_fname}
         ,ostream{}
     {
-        ostream = std::fopen(ofname.c_str(), "r+b");
+        ostream = std::fopen(ofname.c_str(), "w+b");
         assert(ostream);
     }
+    ~impl()
+    { std::fclose(ostream); }
 
     std::FILE* stream() { return ostream; }
-    void reset() { std::fseek(ostream, SEEK_SET, 0); }
-    std::size_t size() { return file_size(ofname.c_str()); }
+    void reset() { std::fseek(ostream, 0, SEEK_SET); }
+    // the written bytes, not the size of the file which is preallocated by reserve()
+    std::size_t size() {
+        const auto pos = std::ftell(ostream);
+
+        return pos < 0 ? 0 : static_cast<std::size_t>(pos);
+    }
     void reserve(std::size_t size) {
-        assert(::ftruncate(fileno(ostream), size) == 0);
+        std::fflush(ostream);
+        const auto rc = ::ftruncate(fileno(ostream), size);
+        assert(rc == 0);
+        (void)rc;
     }
+    void resize(std::size_t size) { return reserve(size); }
 
     std::string ofname;
     std::FILE *ostream;
@@ -317,6 +451,10 @@ void output_stdio_stream_io::reset() { return pimpl->reset(); }
 const std::string& output_stdio_stream_io::name() const { return pimpl->ofname; }
 std::size_t output_stdio_stream_io::size() const { return pimpl->size(); }
 void output_stdio_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void output_stdio_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+bool output_stdio_stream_io::write_all(const char *ptr, std::size_t size)
+{ return std::fwrite(ptr, 1, size, pimpl->ostream) == size; }
 
 std::FILE* output_stdio_stream_io::stream()
 { return pimpl->stream(); }
@@ -331,18 +469,29 @@ struct input_fd_stream_io::impl {
         istream = ::open(ifname.c_str(), O_RDONLY);
         assert(istream != -1);
     }
+    ~impl()
+    { ::close(istream); }
 
     int stream() {
         ::lseek(istream, 0, SEEK_SET);
 
         return istream;
     }
+    std::pair<const char *, std::size_t> read_all() {
+        buffer.resize(size());
+        ::lseek(istream, 0, SEEK_SET);
+        buffer.resize(read_fd(istream, buffer.data(), buffer.size()));
+
+        return {buffer.data(), buffer.size()};
+    }
     void reset() { ::lseek(istream, 0, SEEK_SET); }
     std::size_t size() { return file_size(ifname.c_str()); }
     void reserve(std::size_t /*size*/) {}
+    void resize(std::size_t /*size*/) {}
 
     std::string ifname;
     int istream;
+    std::string buffer;
 };
 
 input_fd_stream_io::input_fd_stream_io(const std::string &input_fname)
@@ -355,6 +504,10 @@ void input_fd_stream_io::reset() { return pimpl->reset(); }
 const std::string& input_fd_stream_io::name() const { return pimpl->ifname; }
 std::size_t input_fd_stream_io::size() const { return pimpl->size(); }
 void input_fd_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void input_fd_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+std::pair<const char *, std::size_t> input_fd_stream_io::read_all()
+{ return pimpl->read_all(); }
 
 int input_fd_stream_io::stream()
 { return pimpl->stream(); }
@@ -366,14 +519,26 @@ struct output_fd_stream_io::impl {
         :ofname{output_fname}
         ,ostream{-1}
     {
-        ostream = ::open(ofname.c_str(), O_RDWR|O_CREAT, S_IRUSR|S_IWUSR);
+        ostream = ::open(ofname.c_str(), O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
         assert(ostream != -1);
     }
+    ~impl()
+    { ::close(ostream); }
 
     int stream() { return ostream; }
     void reset() { ::lseek(ostream, 0, SEEK_SET); }
-    std::size_t size() { return file_size(ofname.c_str()); }
-    void reserve(std::size_t size) { assert(::ftruncate(ostream, size) == 0); }
+    // the written bytes, not the size of the file which is preallocated by reserve()
+    std::size_t size() {
+        const auto pos = ::lseek(ostream, 0, SEEK_CUR);
+
+        return pos < 0 ? 0 : static_cast<std::size_t>(pos);
+    }
+    void reserve(std::size_t size) {
+        const auto rc = ::ftruncate(ostream, size);
+        assert(rc == 0);
+        (void)rc;
+    }
+    void resize(std::size_t size) { return reserve(size); }
 
     std::string ofname;
     int ostream;
@@ -389,12 +554,15 @@ void output_fd_stream_io::reset() { return pimpl->reset(); }
 const std::string& output_fd_stream_io::name() const { return pimpl->ofname; }
 std::size_t output_fd_stream_io::size() const { return pimpl->size(); }
 void output_fd_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
+void output_fd_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
+
+bool output_fd_stream_io::write_all(const char *ptr, std::size_t size)
+{ return write_fd(pimpl->ostream, ptr, size); }
 
 int output_fd_stream_io::stream()
 { return pimpl->stream(); }
 
 /*************************************************************************************************/
-#endif
 
 struct input_mmap_stream_io::impl {
     impl(const std::string &input_fname)
@@ -424,9 +592,18 @@ std::size_t input_mmap_stream_io::size() const { return pimpl->size(); }
 void input_mmap_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void input_mmap_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+std::pair<const char *, std::size_t> input_mmap_stream_io::read_all()
+{ return pimpl->stream(); }
+
 std::pair<char *, std::size_t> input_mmap_stream_io::stream()
 { return pimpl->stream(); }
 
+bool input_mmap_stream_io::drop_page_cache()
+{ return pimpl->istream.drop_page_cache(); }
+
+void input_mmap_stream_io::prefault()
+{ return pimpl->istream.prefault(); }
+
 /*************************************************************************************************/
 
 struct output_mmap_stream_io::impl {
@@ -439,14 +616,24 @@ struct output_mmap_stream_io::impl {
         return {ostream.data(), ostream.size()};
     }
 
-    void reset() {}
+    void reset() { pos = 0; }
 
-    std::size_t size() { return ostream.size(); }
+    void write_all(const char *ptr, std::size_t size) {
+        if ( pos + size > ostream.size() ) {
+            ostream.resize(pos + size);
+        }
+        std::memcpy(ostream.data() + pos, ptr, size);
+        pos += size;
+    }
+
+    // the written bytes, not the size of the mapping which is preallocated by reserve()
+    std::size_t size() { return pos; }
     void reserve(std::size_t size) { ostream.resize(size); }
     void resize(std::size_t size) { return reserve(size); }
 
     std::string ofname;
     mmsink ostream;
+    std::size_t pos = 0; // of write_all()
 };
 
 output_mmap_stream_io::output_mmap_stream_io(const std::string &output_fname)
@@ -461,6 +648,9 @@ std::size_t output_mmap_stream_io::size() const { return pimpl->size(); }
 void output_mmap_stream_io::reserve(std::size_t size) { return pimpl->reserve(size); }
 void output_mmap_stream_io::resize(std::size_t size) { return pimpl->resize(size); }
 
+bool output_mmap_stream_io::write_all(const char *ptr, std::size_t size)
+{ pimpl->write_all(ptr, size); return true; }
+
 std::pair<char *, std::size_t> output_mmap_stream_io::stream()
 { return pimpl->stream(); }
 
@@ -472,16 +662,16 @@ std::unique_ptr<io_device> create_io(io_direction dir, io_type type, const std::
     static const creator map[2][6] = {
          {   [](const std::string &fname) -> ptr { return std::make_unique<input_string_buffer_io>(fname); }
             ,[](const std::string &fname) -> ptr { return std::make_unique<input_std_strstream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<input_std_fstream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<input_stdio_stream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<input_fd_stream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<input_std_fstream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<input_stdio_stream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<input_fd_stream_io>(fname); }
             ,[](const std::string &fname) -> ptr { return std::make_unique<input_mmap_stream_io>(fname); }
          }
         ,{   [](const std::string &fname) -> ptr { return std::make_unique<output_string_buffer_io>(fname); }
             ,[](const std::string &fname) -> ptr { return std::make_unique<output_std_strstream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<output_std_fstream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<output_stdio_stream_io>(fname); }
-//            ,[](const std::string &fname) -> ptr { return std::make_unique<output_fd_stream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<output_std_fstream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<output_stdio_stream_io>(fname); }
+            ,[](const std::string &fname) -> ptr { return std::make_unique<output_fd_stream_io>(fname); }
             ,[](const std::string &fname) -> ptr { return std::make_unique<output_mmap_stream_io>(fname); }
          }
     };
@@ -3,7 +3,10 @@
 
 #include <string>
 #include <memory>
+#include <utility>
+#include <tuple>
 #include <iosfwd>
+#include <cstdio>
 
 #include <cassert>
 
@@ -15,24 +18,24 @@ namespace json_benchmarks {
 enum class io_type {
      string_buffer // string used as I/O buffer
     ,std_strstreams// istringstream/istringstream
-//    ,std_fstreams  // std::istream/std::ostream
-//    ,stdio_streams // fopen()/fread(), etc
-//    ,fd_streams    // open()/read(), etc
+    ,std_fstreams  // std::ifstream/std::fstream
+    ,stdio_streams // fopen()/fread(), etc
+    ,fd_streams    // open()/read(), etc
     ,mmap_streams  // memory mapped
 };
 
 struct input_string_buffer_io;
 struct input_std_strstream_io;
-//struct input_std_fstream_io;
-//struct input_stdio_stream_io;
-//struct input_fd_stream_io;
+struct input_std_fstream_io;
+struct input_stdio_stream_io;
+struct input_fd_stream_io;
 struct input_mmap_stream_io;
 
 struct output_string_buffer_io;
 struct output_std_strstream_io;
-//struct output_std_fstream_io;
-//struct output_stdio_stream_io;
-//struct output_fd_stream_io;
+struct output_std_fstream_io;
+struct output_stdio_stream_io;
+struct output_fd_stream_io;
 struct output_mmap_stream_io;
 
 // don't rearrange!
@@ -50,15 +53,20 @@ struct io_device {
     virtual std::size_t size() const = 0;
     virtual void reserve(std::size_t size) = 0;
     virtual void resize(std::size_t size) = 0;
+    // the whole input as the contiguous bytes. the buffer and the mapped devices return their memory,
+    // the stream devices read the input into their own buffer on each call, so the reading is measured
+    virtual std::pair<const char *, std::size_t> read_all();
+    // writes the bytes at the current position of the output, false when the device failed
+    virtual bool write_all(const char *ptr, std::size_t size);
 
     template<io_type type>
     auto* input_io() {
         using set = std::tuple<
              input_string_buffer_io
             ,input_std_strstream_io
-//            ,input_std_fstream_io
-//            ,input_stdio_stream_io
-//            ,input_fd_stream_io
+            ,input_std_fstream_io
+            ,input_stdio_stream_io
+            ,input_fd_stream_io
             ,input_mmap_stream_io
         >;
         using impl_type = typename std::tuple_element<static_cast<std::size_t>(type), set>::type;
@@ -73,9 +81,9 @@ struct io_device {
         using set = std::tuple<
              output_string_buffer_io
             ,output_std_strstream_io
-//            ,output_std_fstream_io
-//            ,output_stdio_stream_io
-//            ,output_fd_stream_io
+            ,output_std_fstream_io
+            ,output_stdio_stream_io
+            ,output_fd_stream_io
             ,output_mmap_stream_io
         >;
         using impl_type = typename std::tuple_element<static_cast<std::size_t>(type), set>::type;
@@ -101,6 +109,7 @@ struct input_string_buffer_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     std::string& stream();
 
@@ -120,6 +129,7 @@ struct output_string_buffer_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     std::string& stream();
 
@@ -128,7 +138,6 @@ private:
     std::unique_ptr<impl> pimpl;
 };
 
-#if 0
 struct input_std_fstream_io: io_device {
     input_std_fstream_io(const std::string &input_fname);
     virtual ~input_std_fstream_io() = default;
@@ -139,6 +148,8 @@ struct input_std_fstream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     std::istream& stream();
 
@@ -157,6 +168,8 @@ struct output_std_fstream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     std::ostream& stream();
 
@@ -164,7 +177,6 @@ private:
     struct impl;
     std::unique_ptr<impl> pimpl;
 };
-#endif
 
 struct input_std_strstream_io: io_device {
     // the input file will be read into input stream on construction
@@ -178,6 +190,7 @@ struct input_std_strstream_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     std::istream& stream();
 
@@ -197,6 +210,7 @@ struct output_std_strstream_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     std::ostringstream& stream();
 
@@ -205,7 +219,6 @@ private:
     std::unique_ptr<impl> pimpl;
 };
 
-#if 0
 struct input_stdio_stream_io: io_device {
     input_stdio_stream_io(const std::string &input_fname);
     virtual ~input_stdio_stream_io() = default;
@@ -216,6 +229,8 @@ struct input_stdio_stream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     std::FILE* stream();
 
@@ -234,6 +249,8 @@ struct output_stdio_stream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     std::FILE* stream();
 
@@ -252,6 +269,8 @@ struct input_fd_stream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     int stream();
 
@@ -270,6 +289,8 @@ struct output_fd_stream_io: io_device {
     virtual const std::string& name() const override;
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
+    virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     int stream();
 
@@ -277,7 +298,6 @@ private:
     struct impl;
     std::unique_ptr<impl> pimpl;
 };
-#endif
 
 struct input_mmap_stream_io: io_device {
     input_mmap_stream_io(const std::string &input_fname);
@@ -290,9 +310,15 @@ struct input_mmap_stream_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual std::pair<const char *, std::size_t> read_all() override;
 
     std::pair<char *, std::size_t> stream();
 
+    // evicts the input file from the page cache
+    bool drop_page_cache();
+    // faults in all the pages of the input file
+    void prefault();
+
 private:
     struct impl;
     std::unique_ptr<impl> pimpl;
@@ -309,6 +335,7 @@ struct output_mmap_stream_io: io_device {
     virtual std::size_t size() const override;
     virtual void reserve(std::size_t size) override;
     virtual void resize(std::size_t size) override;
+    virtual bool write_all(const char *ptr, std::size_t size) override;
 
     std::pair<char *, std::size_t> stream();
 
@@ -319,6 +346,8 @@ private:
 
 /*************************************************************************************************/
 
+const char* io_type_name(io_type type);
+
 std::unique_ptr<io_device> create_io(io_direction dir, io_type type, const std::string &fname);
 
 /*************************************************************************************************/
@@ -0,0 +1,124 @@
+
+#include "ipc.hpp"
+
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+bool write_all(int fd, const char *ptr, std::size_t size) {
+    while ( size ) {
+        auto wr = ::write(fd, ptr, size);
+        if ( wr < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( wr <= 0 ) {
+            return false;
+        }
+        ptr += wr;
+        size -= wr;
+    }
+
+    return true;
+}
+
+bool read_all(int fd, std::string *dst) {
+    char buf[64 * 1024];
+    for ( ;; ) {
+        auto rd = ::read(fd, buf, sizeof(buf));
+        if ( rd < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( rd < 0 ) {
+            return false;
+        }
+        if ( rd == 0 ) {
+            return true;
+        }
+        dst->append(buf, rd);
+    }
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
+std::pair<bool, std::string> run_isolated(
+     measurements *res
+    ,const std::function<std::pair<bool, std::string>(measurements *)> &f)
+{
+    int fds[2];
+    if ( ::pipe(fds) != 0 ) {
+        return {false, std::string{"pipe(): "} + std::strerror(errno)};
+    }
+
+    // otherwise the buffered output would be printed twice
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = ::fork();
+    if ( pid < 0 ) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+
+        return {false, std::string{"fork(): "} + std::strerror(errno)};
+    }
+
+    if ( pid == 0 ) {
+        ::close(fds[0]);
+
+        measurements m;
+        auto [ok, emsg] = f(&m);
+        std::cout.flush();
+        std::cerr.flush();
+
+        ipc_writer wr;
+        wr & ok & emsg;
+        transfer(wr, m);
+        bool sent = write_all(fds[1], wr.buf.data(), wr.buf.size());
+        ::close(fds[1]);
+
+        // the atexit handlers and the destructors of the statics belong to the parent
+        ::_exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    ::close(fds[1]);
+    std::string buf;
+    bool received = read_all(fds[0], &buf);
+    ::close(fds[0]);
+
+    int status = 0;
+    while ( ::waitpid(pid, &status, 0) < 0 && errno == EINTR )
+    {}
+
+    if ( WIFSIGNALED(status) ) {
+        return {false, std::string{"the child process was killed by signal: "} + ::strsignal(WTERMSIG(status))};
+    }
+    if ( !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS || !received ) {
+        return {false, "the child process failed to send the measurements"};
+    }
+
+    bool ok = false;
+    std::string emsg;
+    ipc_reader rd{buf};
+    rd & ok & emsg;
+    transfer(rd, *res);
+    if ( !rd.ok ) {
+        return {false, "the measurements received from the child process are truncated"};
+    }
+
+    return {ok, std::move(emsg)};
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
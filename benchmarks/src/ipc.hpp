@@ -0,0 +1,261 @@
+#ifndef JSON_BENCHMARKS_IPC_HPP
+#define JSON_BENCHMARKS_IPC_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <ostream>
+#include <cstring>
+
+#include "measurements.hpp"
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+// don't rearrange!
+enum class isolation_mode {
+     none    // all the libraries are run in the harness process
+    ,library // a fresh child process for each library
+    ,trial   // a fresh child process for each measured trial
+};
+
+static constexpr const char *s_isolation_mode[] = {
+     "none"
+    ,"library"
+    ,"trial"
+};
+
+inline std::ostream& operator<< (std::ostream &os, isolation_mode v) {
+    return os << s_isolation_mode[static_cast<std::size_t>(v)];
+}
+
+/*************************************************************************************************/
+
+// the binary archives used to pass the measurements through a pipe.
+// both the sides are the same binary, so the layout of the trivial types is the same.
+struct ipc_writer {
+    std::string buf;
+
+    template<typename T>
+    typename std::enable_if<std::is_trivially_copyable<T>::value, ipc_writer&>::type
+    operator& (const T &v) {
+        buf.append(reinterpret_cast<const char *>(&v), sizeof(v));
+
+        return *this;
+    }
+    ipc_writer& operator& (const std::string &v) {
+        *this & v.size();
+        buf.append(v);
+
+        return *this;
+    }
+    // the structures with the non-trivial members provide their own transfer()
+    template<typename T>
+    typename std::enable_if<std::is_class<T>::value && !std::is_trivially_copyable<T>::value, ipc_writer&>::type
+    operator& (const T &v) {
+        transfer(*this, v);
+
+        return *this;
+    }
+    template<typename T>
+    ipc_writer& operator& (const std::vector<T> &v) {
+        *this & v.size();
+        for ( const auto &it: v ) {
+            *this & it;
+        }
+
+        return *this;
+    }
+};
+
+struct ipc_reader {
+    const std::string &buf;
+    std::size_t pos;
+    bool ok;
+
+    explicit ipc_reader(const std::string &b)
+        :buf{b}
+        ,pos{}
+        ,ok{true}
+    {}
+
+    template<typename T>
+    typename std::enable_if<std::is_trivially_copyable<T>::value, ipc_reader&>::type
+    operator& (T &v) {
+        if ( !ok || buf.size() - pos < sizeof(v) ) {
+            ok = false;
+
+            return *this;
+        }
+        std::memcpy(&v, buf.data() + pos, sizeof(v));
+        pos += sizeof(v);
+
+        return *this;
+    }
+    ipc_reader& operator& (std::string &v) {
+        std::size_t size = 0;
+        *this & size;
+        if ( !ok || buf.size() - pos < size ) {
+            ok = false;
+
+            return *this;
+        }
+        v.assign(buf.data() + pos, size);
+        pos += size;
+
+        return *this;
+    }
+    template<typename T>
+    typename std::enable_if<std::is_class<T>::value && !std::is_trivially_copyable<T>::value, ipc_reader&>::type
+    operator& (T &v) {
+        transfer(*this, v);
+
+        return *this;
+    }
+    template<typename T>
+    ipc_reader& operator& (std::vector<T> &v) {
+        std::size_t size = 0;
+        *this & size;
+        if ( !ok || size > buf.size() - pos ) {
+            ok = false;
+
+            return *this;
+        }
+        v.resize(size);
+        for ( auto &it: v ) {
+            *this & it;
+        }
+
+        return *this;
+    }
+};
+
+template<typename Archive, typename S>
+typename std::enable_if<std::is_same<typename std::remove_const<S>::type, alloc_site>::value>::type
+transfer(Archive &ar, S &s) {
+    ar
+        & s.stack
+        & s.bytes
+        & s.allocations
+    ;
+}
+
+template<typename Archive, typename H>
+typename std::enable_if<std::is_same<typename std::remove_const<H>::type, hdr_histogram>::value>::type
+transfer(Archive &ar, H &h) {
+    hdr_histogram::transfer(ar, h);
+}
+
+template<typename Archive, typename C>
+typename std::enable_if<std::is_same<typename std::remove_const<C>::type, chunked_parse_result>::value>::type
+transfer(Archive &ar, C &c) {
+    ar
+        & c.chunk_size
+        & c.samples
+        & c.stats
+        & c.chunk_hist
+        & c.allocated
+        & c.allocations
+    ;
+}
+
+template<typename Archive, typename T>
+typename std::enable_if<std::is_same<typename std::remove_const<T>::type, traverse_result>::value>::type
+transfer(Archive &ar, T &t) {
+    ar
+        & t.pattern
+        & t.samples
+        & t.stats
+        & t.allocated
+        & t.allocations
+        & t.values
+        & t.strings
+        & t.numbers
+    ;
+}
+
+// the single list of the transferred fields, used for both the directions.
+// every new field of 'measurements' must be added here.
+template<typename Archive, typename M>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, measurements>::value>::type
+transfer(Archive &ar, M &m) {
+    ar
+        & m.name
+        & m.errmsg
+        & m.prepare_allocated
+        & m.prepare_allocations
+        & m.prepare_deallocations
+        & m.time_to_prepare
+        & m.parse_allocated
+        & m.parse_allocations
+        & m.parse_deallocations
+        & m.time_to_parse
+        & m.print_allocated
+        & m.print_allocations
+        & m.print_deallocations
+        & m.time_to_print
+        & m.free_deallocated
+        & m.free_deallocations
+        & m.free_leaked_bytes
+        & m.free_leaked_allocations
+        & m.time_to_free
+        & m.leaks_as_expected
+        & m.converged
+        & m.first_trial_time
+        & m.first_trial_allocated
+        & m.first_trial_allocations
+        & m.time_to_sax_parse
+        & m.sax_parse_allocated
+        & m.sax_parse_allocations
+        & m.sax_events
+        & m.sax_numbers
+        & m.chunked
+        & m.traversed
+        & m.warmups
+        & m.prepare_samples
+        & m.parse_samples
+        & m.print_samples
+        & m.free_samples
+        & m.sax_parse_samples
+        & m.prepare_stats
+        & m.parse_stats
+        & m.print_stats
+        & m.free_stats
+        & m.sax_parse_stats
+        & m.prepare_counters
+        & m.parse_counters
+        & m.print_counters
+        & m.free_counters
+        & m.prepare_usage
+        & m.parse_usage
+        & m.print_usage
+        & m.free_usage
+        & m.prepare_alloc_profile
+        & m.parse_alloc_profile
+        & m.print_alloc_profile
+        & m.free_alloc_profile
+        & m.parse_alloc_sites
+        & m.print_alloc_sites
+        & m.alloc_timeline
+        & m.input_size
+        & m.output_size
+        & m.json_values
+    ;
+}
+
+/*************************************************************************************************/
+
+// forks a child which calls 'f' and sends the filled 'measurements' back through a pipe.
+// returns false with the error message if 'f' failed, or the child crashed.
+std::pair<bool, std::string> run_isolated(
+     measurements *res
+    ,const std::function<std::pair<bool, std::string>(measurements *)> &f
+);
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_IPC_HPP
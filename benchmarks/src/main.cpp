@@ -1,11 +1,17 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <string>
 #include <vector>
+#include <set>
+#include <tuple>
+#include <algorithm>
 #include <cstring>
+#include <cctype>
 #include <cassert>
+#include <ctime>
 
 #include "measurements.hpp"
 #include "benchmarks.hpp"
@@ -13,6 +19,16 @@
 #include "data_generator.hpp"
 #include "os_tools.hpp"
 #include "io_device.hpp"
+#include "timer.hpp"
+#include "perf_counters.hpp"
+#include "perf_sampler.hpp"
+#include "ipc.hpp"
+#include "alloc_tracker.hpp"
+#include "results.hpp"
+#include "history.hpp"
+#include "hdr_histogram.hpp"
+#include "scaling.hpp"
+#include "allocators.hpp"
 
 #include <malloc-stat/api.h>
 #include <cmdargs/cmdargs.hpp>
@@ -25,305 +41,1791 @@ malloc_stat_get_stat_fnptr get_alloc_stat = nullptr;
 
 /*************************************************************************************************/
 
-#ifdef SMALL_FILE_TEST_ENABLED
-bool benchmarks_small_file(
-     std::size_t iter_times
-    ,const benchmarks_list &implementations
+// don't rearrange!
+enum class cache_mode {
+     as_is // nothing is done, the state of the caches depends on the previous trial
+    ,cold  // the input is evicted from the page cache and from the CPU caches before each parse
+    ,hot   // the input is prefaulted and parsed once untimed before the measurements
+};
+
+static constexpr const char *s_cache_mode[] = {
+     "as_is"
+    ,"cold"
+    ,"hot"
+};
+
+std::ostream& operator<< (std::ostream &os, cache_mode v) {
+    return os << s_cache_mode[static_cast<std::size_t>(v)];
+}
+
+struct benchmark_options {
+    std::size_t json_flags;
+    std::size_t warmups;    // untimed trials before the measured ones
+    std::size_t iterations; // measured trials
+    std::size_t bootstrap_resamples;
+    // in adaptive mode 'iterations' is the minimum, the trials continue
+    // until the CI of the parse and print medians is narrow enough
+    bool adaptive;
+    double target_ci;       // relative CI half-width, 0.01 means +/-1%
+    std::uint64_t time_budget_ns; // per library, including the warmups
+    std::size_t max_iterations;
+    int cpu;                // the CPU the benchmark thread is pinned to, -1 if not pinned
+    int fifo_priority;      // SCHED_FIFO priority, zero for the default scheduling
+    isolation_mode isolation;
+    cache_mode cache;
+    bool alloc_profile;     // run one more untimed trial with the allocations tracking
+    std::size_t alloc_sites; // the number of the top call stacks to report, zero disables the backtraces
+    std::size_t alloc_timeline; // sample the live bytes each N allocations, zero to disable
+    std::string baseline_fname; // the JSON results of a previous run, empty to skip the comparison
+    regression_thresholds thresholds;
+    std::string history_fname; // the results of each run are appended here, empty to disable
+    std::string profile_library; // the library to run the sampling profiler for, "all", or empty to disable
+    trial_phase profile_phase;   // any, the traverse one is sampled in the traverse trials
+    std::size_t profile_frequency; // samples per second
+    std::vector<allocator_kind> allocators; // each library is run with each of them it supports
+    bool reuse;             // run the libraries supporting it in the reuse mode too
+    bool io_matrix;         // run each library with each input/output devices pair it supports
+    bool sax;               // measure the SAX parse of the libraries supporting it too
+    std::vector<std::size_t> chunk_sizes; // measure the chunked parse with each of them, empty to disable
+    bool traverse;          // measure the reads of the parsed document by the libraries supporting it
+    io_type input_io;       // the devices of the current run, see benchmark()
+    io_type output_io;
+};
+
+// the header of the environment table of the reports
+void write_environment_info(std::ostream &os) {
+    os << "Environment"
+       << "|" << get_os_type() << ", " << get_cpu_type() << std::endl;
+    os << "---|---" << std::endl;
+    os << "Computer"
+       << "|" << get_motherboard() << ", " << get_cpu() << ", " << get_ram() << std::endl;
+    os << "Operating system"
+       << "|" << get_os() << std::endl;
+    os << "Compiler"
+       << "|" << get_compiler() << std::endl;
+}
+
+// checks that nothing disturbs the measurements on the CPU we are running on
+// and writes the state into the report
+void write_isolation_info(std::ostream &os, const benchmark_options &opts) {
+    const int cpu = opts.cpu >= 0 ? opts.cpu : get_current_cpu();
+    const auto governor = get_cpufreq_governor(cpu);
+    const auto turbo = get_turbo_state();
+    const auto siblings = get_smt_siblings(cpu);
+
+    os << "CPU pinning"
+       << "|" << (opts.cpu >= 0 ? "cpu " + std::to_string(opts.cpu) : std::string{"not pinned"})
+       << ", " << (opts.fifo_priority ? "SCHED_FIFO/" + std::to_string(opts.fifo_priority) : std::string{"SCHED_OTHER"})
+       << std::endl;
+    os << "CPU frequency governor"
+       << "|" << governor << std::endl;
+    os << "Turbo/boost"
+       << "|" << turbo << std::endl;
+
+    if ( governor != "performance" && governor != "UNKNOWN" ) {
+        std::cerr << "  WARN: cpufreq governor for cpu " << cpu << " is \"" << governor
+                  << "\", the results may vary because of frequency scaling" << std::endl;
+    }
+    if ( turbo == "enabled" ) {
+        std::cerr << "  WARN: turbo/boost is enabled, the results may vary because of thermal throttling" << std::endl;
+    }
+
+    os << "SMT siblings";
+    if ( siblings.empty() ) {
+        os << "|none" << std::endl;
+    } else {
+        os << "|";
+        for ( auto i = 0u; i < siblings.size(); ++i ) {
+            const auto load = get_cpu_load(siblings[i], 200);
+            os << (i ? ", " : "") << "cpu " << siblings[i] << " (load " << load << "%)";
+            if ( load > 5.0 ) {
+                std::cerr << "  WARN: the SMT sibling cpu " << siblings[i] << " is busy (" << load
+                          << "%), it shares the core resources with the benchmark" << std::endl;
+            }
+        }
+        os << std::endl;
+    }
+}
+
+// the same as in the report header, for the machine-readable results
+run_environment make_environment(
+     const std::string &suite
+    ,const std::string &input_fname
+    ,std::size_t fsize
+    ,std::size_t json_values
+    ,const benchmark_options &opts)
+{
+    char date[32];
+    auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    auto str = [](const auto &v) {
+        std::ostringstream os;
+        os << v;
+
+        return os.str();
+    };
+
+    return {
+         {"date", date}
+        ,{"os_type", get_os_type()}
+        ,{"os", get_os()}
+        ,{"compiler", get_compiler()}
+        ,{"motherboard", get_motherboard()}
+        ,{"cpu_type", get_cpu_type()}
+        ,{"cpu", get_cpu()}
+        ,{"ram", get_ram()}
+        ,{"timer", clock_source_name(phase_timer::source())}
+        ,{"tsc_hz", str(phase_timer::tsc_hz())}
+        ,{"timer_overhead_ns", str(phase_timer::overhead_ns())}
+        ,{"commit", get_git_commit()}
+        ,{"machine", get_machine_fingerprint()}
+        ,{"suite", suite}
+        ,{"input", input_fname}
+        ,{"dataset_hash", get_dataset_hash(input_fname)}
+        ,{"input_size", str(fsize)}
+        ,{"json_values", str(json_values)}
+        ,{"json_flags", str(opts.json_flags)}
+        ,{"warmups", str(opts.warmups)}
+        ,{"iterations", str(opts.iterations)}
+        ,{"adaptive", str(opts.adaptive)}
+        ,{"target_ci", str(opts.target_ci)}
+        ,{"cpu_pinning", str(opts.cpu)}
+        ,{"fifo_priority", str(opts.fifo_priority)}
+        ,{"isolation", str(opts.isolation)}
+        ,{"cache", str(opts.cache)}
+        ,{"alloc_profile", str(opts.alloc_profile)}
+    };
+}
+
+struct phase_sample {
+    std::uint64_t time;
+    malloc_stat_vars alloc;
+    perf_counters counters;
+    resource_usage usage;
+};
+
+struct trial_sample {
+    phase_sample prepare;
+    phase_sample parse;
+    phase_sample print;
+    phase_sample free;
+};
+
+// 'sampler' is enabled around the phase when not nullptr
+template<typename F>
+phase_sample measure_phase(benchmarks *impl, perf_group *counters, perf_sampler *sampler, trial_phase ph, F &&f) {
+    phase_sample res;
+
+    alloc_tracker::set_phase(ph);
+
+    // the counters and the resource usage are sampled outside of the timed region
+    // so the ioctl()/getrusage() cost is not included into the phase time
+    const auto usage_start = get_resource_usage();
+    counters->start();
+    auto start = impl->start_time();
+    MALLOC_STAT_RESET_STAT(get_alloc_stat);
+    if ( sampler ) {
+        sampler->enable();
+    }
+
+    f();
+
+    if ( sampler ) {
+        sampler->disable();
+    }
+    res.alloc = MALLOC_STAT_GET_STAT(get_alloc_stat);
+    res.time = impl->duration(start);
+    res.counters = counters->stop();
+    res.usage = resource_usage_delta(usage_start, get_resource_usage());
+
+    return res;
+}
+
+// evicts the input from the page cache (when it's a mapped file) and from the CPU caches
+void make_input_cold(io_device *input_io) {
+    if ( input_io->type() == io_type::mmap_streams ) {
+        if ( !input_io->input_io<io_type::mmap_streams>()->drop_page_cache() ) {
+            std::cerr << "  WARN: can't drop the page cache of the input file" << std::endl;
+        }
+    }
+    flush_cpu_caches();
+}
+
+// makes sure the next access to the input will not cause a page fault
+void make_input_hot(io_device *input_io) {
+    if ( input_io->type() == io_type::mmap_streams ) {
+        input_io->input_io<io_type::mmap_streams>()->prefault();
+    }
+}
+
+// decides if one more trial is required
+bool need_more_trials(
+     const benchmark_options &opts
+    ,const measurements &stat
+    ,std::size_t trial
+    ,std::uint64_t start_ticks
+    ,std::size_t *next_check
+    ,bool *converged)
+{
+    if ( trial < opts.warmups + opts.iterations ) {
+        return true;
+    }
+    if ( !opts.adaptive ) {
+        return false;
+    }
+
+    const auto measured = trial - opts.warmups;
+    if ( measured >= opts.max_iterations ) {
+        return false;
+    }
+    if ( phase_timer::to_ns(phase_timer::now() - start_ticks) >= opts.time_budget_ns ) {
+        return false;
+    }
+
+    // the bootstrap is not free, so the CI is re-checked each time
+    // the number of samples grows by 25%
+    if ( measured >= *next_check ) {
+        *next_check = measured + std::max<std::size_t>(measured / 4, 1);
+
+        auto parse_ci = compute_stats(stat.parse_samples, opts.bootstrap_resamples).ci_rel_halfwidth();
+        auto print_ci = compute_stats(stat.print_samples, opts.bootstrap_resamples).ci_rel_halfwidth();
+        if ( parse_ci <= opts.target_ci && print_ci <= opts.target_ci ) {
+            *converged = true;
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// runs the prepare/parse/print/finish sequence once.
+// the 'sampler' is enabled around the 'sampled_phase' only
+std::pair<bool, std::string> run_trial(
+     trial_sample *res
+    ,benchmarks *impl
+    ,perf_group *counters
+    ,io_device *input_io
+    ,io_device *output_io
+    ,std::size_t json_flags
+    ,cache_mode cache
+    ,perf_sampler *sampler = nullptr
+    ,trial_phase sampled_phase = trial_phase::count_)
+{
+    auto sampler_for = [&](trial_phase ph) { return ph == sampled_phase ? sampler : nullptr; };
+
+    // the output buffer is restored before every trial so the print phase
+    // always starts with the same reserved capacity.
+    // it's not the part of any phase, so it's not counted in the live bytes of the profiled trial
+    alloc_tracker::suspend();
+    output_io->reset();
+    output_io->reserve(input_io->size() * 2);
+    alloc_tracker::resume();
+
+    if ( cache == cache_mode::hot ) {
+        make_input_hot(input_io);
+    }
+
+    res->prepare = measure_phase(impl, counters, sampler_for(trial_phase::prepare), trial_phase::prepare, [&]{
+        impl->prepare(input_io, json_flags);
+    });
+
+    // is done after the prepare phase, because some of the libraries
+    // walk through the input there to preallocate the storage
+    if ( cache == cache_mode::cold ) {
+        make_input_cold(input_io);
+    }
+
+    std::pair<bool, std::string> parse_res;
+    res->parse = measure_phase(impl, counters, sampler_for(trial_phase::parse), trial_phase::parse, [&]{
+        parse_res = impl->parse(input_io, json_flags);
+    });
+    if ( !parse_res.first ) {
+        return {false, "the PARSE benchmark for \"" + impl->variant_name() + "\" finished with error: " + parse_res.second};
+    }
+
+    std::pair<bool, std::string> print_res;
+    res->print = measure_phase(impl, counters, sampler_for(trial_phase::print), trial_phase::print, [&]{
+        print_res = impl->print(output_io, json_flags);
+    });
+    if ( !print_res.first ) {
+        return {false, "the PRINT benchmark for \"" + impl->variant_name() + "\" finished with error: " + print_res.second};
+    }
+
+    // the arena is released at once, so it's the part of the free phase
+    res->free = measure_phase(impl, counters, sampler_for(trial_phase::free), trial_phase::free, [&]{
+        impl->finish();
+        reset_allocator();
+    });
+
+    return {true, std::string{}};
+}
+
+// runs the SAX parse trials of one library, the warmups are untimed as for the DOM trials
+std::pair<bool, std::string> run_sax_trials(
+     measurements *stat
+    ,benchmarks *impl
+    ,perf_group *counters
+    ,io_device *input_io
+    ,const benchmark_options &opts)
+{
+    for ( std::size_t trial = 0; trial < opts.warmups + opts.iterations; ++trial ) {
+        if ( opts.cache == cache_mode::hot ) {
+            make_input_hot(input_io);
+        } else if ( opts.cache == cache_mode::cold ) {
+            make_input_cold(input_io);
+        }
+
+        sax_totals totals{};
+        std::pair<bool, std::string> sax_res;
+        auto sample = measure_phase(impl, counters, nullptr, trial_phase::parse, [&]{
+            sax_res = impl->sax_parse(input_io, opts.json_flags, &totals);
+        });
+        reset_allocator();
+        if ( !sax_res.first ) {
+            return {false, "the SAX PARSE benchmark for \"" + impl->variant_name() + "\" finished with error: " + sax_res.second};
+        }
+
+        if ( trial < opts.warmups ) {
+            continue;
+        }
+
+        stat->sax_parse_samples.push_back(sample.time);
+        stat->sax_parse_allocated = sample.alloc.allocated;
+        stat->sax_parse_allocations = sample.alloc.allocations;
+        stat->sax_events = totals.events;
+        stat->sax_numbers = totals.numbers;
+    }
+
+    return {true, std::string{}};
+}
+
+// feeds the mapped input to the incremental parser in the chunks of each size,
+// each parse_chunk() call is timed separately for the latency percentiles
+std::pair<bool, std::string> run_chunked_trials(
+     measurements *stat
+    ,benchmarks *impl
+    ,const std::string &input_fname
+    ,const benchmark_options &opts)
+{
+    auto input_io = create_io(io_direction::input, io_type::mmap_streams, input_fname);
+    const auto input = input_io->input_io<io_type::mmap_streams>()->stream();
+    // the parser and the arena must not outlive the failed trial
+    auto failed = [impl](const std::string &emsg) -> std::pair<bool, std::string> {
+        impl->finish();
+        reset_allocator();
+        impl->release();
+
+        return {false, "the CHUNKED PARSE benchmark for \"" + impl->variant_name() + "\" finished with error: " + emsg};
+    };
+
+    for ( const auto chunk_size: opts.chunk_sizes ) {
+        // value-initialized, the histogram has the explicit default constructor
+        auto res = chunked_parse_result();
+        res.chunk_size = chunk_size;
+        for ( std::size_t trial = 0; trial < opts.warmups + opts.iterations; ++trial ) {
+            const bool measured = trial >= opts.warmups;
+            if ( opts.cache == cache_mode::hot ) {
+                make_input_hot(input_io.get());
+            } else if ( opts.cache == cache_mode::cold ) {
+                make_input_cold(input_io.get());
+            }
+
+            // the whole-buffer parse constructs its parser too, so it's the part of the time
+            std::uint64_t total = 0;
+            MALLOC_STAT_RESET_STAT(get_alloc_stat);
+            const auto begin_start = impl->start_time();
+            impl->begin_chunks(opts.json_flags);
+            total += impl->duration(begin_start);
+            for ( std::size_t pos = 0; pos < input.second; pos += chunk_size ) {
+                const auto size = std::min(chunk_size, input.second - pos);
+                const auto start = impl->start_time();
+                auto chunk_res = impl->parse_chunk(input.first + pos, size);
+                const auto time = impl->duration(start);
+                if ( !chunk_res.first ) {
+                    return failed(chunk_res.second);
+                }
+                total += time;
+                if ( measured ) {
+                    res.chunk_hist.record(time);
+                }
+            }
+            const auto start = impl->start_time();
+            auto finish_res = impl->finish_chunks();
+            total += impl->duration(start);
+            const auto alloc = MALLOC_STAT_GET_STAT(get_alloc_stat);
+            if ( !finish_res.first ) {
+                return failed(finish_res.second);
+            }
+            impl->finish();
+            reset_allocator();
+
+            if ( measured ) {
+                res.samples.push_back(total);
+                res.allocated = alloc.allocated;
+                res.allocations = alloc.allocations;
+            }
+        }
+        stat->chunked.push_back(std::move(res));
+    }
+    impl->release();
+
+    return {true, std::string{}};
+}
+
+// parses the input untimed and then reads the document with each of the traverse patterns,
+// each of them is timed separately. the document is hot in the caches after the parse,
+// so the cache mode is not applied
+std::pair<bool, std::string> run_traverse_trials(
+     measurements *stat
+    ,benchmarks *impl
+    ,perf_group *counters
+    ,io_device *input_io
+    ,const benchmark_options &opts
+    ,perf_sampler *sampler = nullptr)
+{
+    std::vector<traverse_result> results(static_cast<std::size_t>(traverse_pattern::count_));
+    // the document and the arena must not outlive the failed trial
+    auto failed = [impl](const std::string &emsg) -> std::pair<bool, std::string> {
+        impl->finish();
+        reset_allocator();
+        impl->release();
+
+        return {false, "the TRAVERSE benchmark for \"" + impl->variant_name() + "\" finished with error: " + emsg};
+    };
+    for ( std::size_t trial = 0; trial < opts.warmups + opts.iterations; ++trial ) {
+        impl->prepare(input_io, opts.json_flags);
+        auto parse_res = impl->parse(input_io, opts.json_flags);
+        if ( !parse_res.first ) {
+            return failed(parse_res.second);
+        }
+
+        for ( std::size_t idx = 0; idx < results.size(); ++idx ) {
+            const auto pattern = static_cast<traverse_pattern>(idx);
+            traverse_totals totals{};
+            std::pair<bool, std::string> traverse_res;
+            auto sample = measure_phase(impl, counters, trial < opts.warmups ? nullptr : sampler, trial_phase::traverse, [&]{
+                traverse_res = impl->traverse(pattern, &totals);
+            });
+            if ( !traverse_res.first ) {
+                return failed(traverse_res.second);
+            }
+
+            if ( trial < opts.warmups ) {
+                continue;
+            }
+
+            auto &res = results[idx];
+            res.pattern = static_cast<std::uint32_t>(pattern);
+            res.samples.push_back(sample.time);
+            res.allocated = sample.alloc.allocated;
+            res.allocations = sample.alloc.allocations;
+            res.values = totals.values;
+            res.strings = totals.strings;
+            res.numbers = totals.numbers;
+        }
+        impl->finish();
+        reset_allocator();
+        if ( sampler ) {
+            sampler->collect();
+        }
+    }
+    impl->release();
+
+    stat->traversed.insert(stat->traversed.end(), results.begin(), results.end());
+
+    return {true, std::string{}};
+}
+
+// runs the trials of one library in the current process, the samples are appended to 'stat'
+std::pair<bool, std::string> run_library(
+     measurements *stat
+    ,benchmarks *impl
+    ,perf_group *counters
+    ,const std::string &input_fname
+    ,const benchmark_options &opts)
+{
+    auto [input_io, output_io] = impl->create_io(input_fname, opts.input_io, opts.output_io);
+
+    auto allowed_leaks = impl->allowed_leaks();
+    const auto start_ticks = phase_timer::now();
+    std::size_t next_check = opts.iterations;
+    for ( std::size_t trial = 0; need_more_trials(opts, *stat, trial, start_ticks, &next_check, &stat->converged); ++trial ) {
+        trial_sample sample;
+        auto [ok, emsg] = run_trial(&sample, impl, counters, input_io.get(), output_io.get(), opts.json_flags, opts.cache);
+        if ( !ok ) {
+            return {false, emsg};
+        }
+
+        auto summ_of_allocs = sample.prepare.alloc.allocations + sample.parse.alloc.allocations
+            + sample.print.alloc.allocations + sample.free.alloc.allocations;
+        auto summ_of_allocated = sample.prepare.alloc.allocated + sample.parse.alloc.allocated
+            + sample.print.alloc.allocated + sample.free.alloc.allocated;
+        auto summ_of_deallocs = sample.prepare.alloc.deallocations + sample.parse.alloc.deallocations
+            + sample.print.alloc.deallocations + sample.free.alloc.deallocations;
+        auto summ_of_deallocated = sample.prepare.alloc.deallocated + sample.parse.alloc.deallocated
+            + sample.print.alloc.deallocated + sample.free.alloc.deallocated;
+        auto leaked_bytes = summ_of_allocated - summ_of_deallocated;
+        auto leaked_allocs = summ_of_allocs - summ_of_deallocs;
+        // the singletons of some libraries are allocated on the first use only,
+        // the same for the chunks and the blocks cached by the harness allocators
+        // and the storage kept by the reuse mode
+        if ( trial == 0 ) {
+            stat->leaks_as_expected = current_allocator() != allocator_kind::system
+                || impl->retains_storage(opts.json_flags)
+                || (allowed_leaks.first == leaked_bytes && allowed_leaks.second == leaked_allocs);
+        } else if ( leaked_bytes || leaked_allocs ) {
+            stat->leaks_as_expected = false;
+        }
+
+        if ( trial == 0 ) {
+            stat->first_trial_time = sample.prepare.time + sample.parse.time;
+            stat->first_trial_allocated = sample.prepare.alloc.allocated + sample.parse.alloc.allocated;
+            stat->first_trial_allocations = sample.prepare.alloc.allocations + sample.parse.alloc.allocations;
+        }
+
+        if ( trial < opts.warmups ) {
+            continue;
+        }
+
+        stat->prepare_samples.push_back(sample.prepare.time);
+        stat->parse_samples.push_back(sample.parse.time);
+        stat->print_samples.push_back(sample.print.time);
+        stat->free_samples.push_back(sample.free.time);
+
+        stat->prepare_counters += sample.prepare.counters;
+        stat->parse_counters += sample.parse.counters;
+        stat->print_counters += sample.print.counters;
+        stat->free_counters += sample.free.counters;
+
+        stat->prepare_usage += sample.prepare.usage;
+        stat->parse_usage += sample.parse.usage;
+        stat->print_usage += sample.print.usage;
+        stat->free_usage += sample.free.usage;
+
+        // the allocations are deterministic, so the last trial is representative
+        stat->prepare_allocated = sample.prepare.alloc.allocated;
+        stat->prepare_allocations = sample.prepare.alloc.allocations;
+        stat->prepare_deallocations = sample.prepare.alloc.deallocations;
+        stat->parse_allocated = sample.parse.alloc.allocated;
+        stat->parse_allocations = sample.parse.alloc.allocations;
+        stat->parse_deallocations = sample.parse.alloc.deallocations;
+        stat->print_allocated = sample.print.alloc.allocated;
+        stat->print_allocations = sample.print.alloc.allocations;
+        stat->print_deallocations = sample.print.alloc.deallocations;
+        stat->free_deallocated = sample.free.alloc.deallocated;
+        stat->free_deallocations = sample.free.alloc.deallocations;
+        stat->free_leaked_bytes = leaked_bytes;
+        stat->free_leaked_allocations = leaked_allocs;
+        stat->output_size = output_io->size();
+    }
+
+    // the tracking slows down every allocation, so the profile
+    // is collected in the extra trial which is not included into the samples
+    if ( opts.alloc_profile && alloc_tracker::available() ) {
+        trial_sample sample;
+        alloc_tracker::start(opts.alloc_sites != 0, opts.alloc_timeline);
+        auto [ok, emsg] = run_trial(&sample, impl, counters, input_io.get(), output_io.get(), opts.json_flags, opts.cache);
+        alloc_tracker::stop();
+        if ( !ok ) {
+            return {false, emsg};
+        }
+
+        stat->prepare_alloc_profile = alloc_tracker::profile(trial_phase::prepare);
+        stat->parse_alloc_profile = alloc_tracker::profile(trial_phase::parse);
+        stat->print_alloc_profile = alloc_tracker::profile(trial_phase::print);
+        stat->free_alloc_profile = alloc_tracker::profile(trial_phase::free);
+        stat->parse_alloc_sites = alloc_tracker::top_sites(trial_phase::parse, opts.alloc_sites);
+        stat->print_alloc_sites = alloc_tracker::top_sites(trial_phase::print, opts.alloc_sites);
+        stat->alloc_timeline = alloc_tracker::timeline();
+    }
+    impl->release();
+
+    if ( opts.sax && impl->supports_sax() ) {
+        auto res = run_sax_trials(stat, impl, counters, input_io.get(), opts);
+        if ( !res.first ) {
+            return res;
+        }
+    }
+    if ( !opts.chunk_sizes.empty() && impl->supports_chunks() ) {
+        auto res = run_chunked_trials(stat, impl, input_fname, opts);
+        if ( !res.first ) {
+            return res;
+        }
+    }
+    if ( opts.traverse && impl->supports_traverse() ) {
+        auto res = run_traverse_trials(stat, impl, counters, input_io.get(), opts);
+        if ( !res.first ) {
+            return res;
+        }
+    }
+
+    ///////////////////////////////////////////////////////// check
+    //auto check_res = impl->check(input_io.get(), output_io.get(), opts.json_flags);
+
+    return {true, std::string{}};
+}
+
+// runs the warmup trials and then as many trials as measured with the sampling profiler
+// enabled around one phase, the samples are written as the folded stacks
+std::pair<bool, std::string> profile_library(
+     benchmarks *impl
+    ,const std::string &input_fname
+    ,const std::string &folded_fname
+    ,const std::string &root
+    ,const benchmark_options &opts)
+{
+    perf_sampler sampler{opts.profile_frequency};
+    if ( !sampler.available() ) {
+        return {false, "the sampling profiler is not available: " + sampler.error()};
+    }
+
+    auto [input_io, output_io] = impl->create_io(input_fname, opts.input_io, opts.output_io);
+    perf_group counters;
+    // the traverse phase is not a part of the trial
+    if ( opts.profile_phase == trial_phase::traverse ) {
+        if ( !impl->supports_traverse() ) {
+            return {false, impl->variant_name() + " doesn't support the traverse"};
+        }
+        measurements unused;
+        auto res = run_traverse_trials(&unused, impl, &counters, input_io.get(), opts, &sampler);
+        if ( !res.first ) {
+            return res;
+        }
+    } else {
+        for ( std::size_t trial = 0; trial < opts.warmups + opts.iterations; ++trial ) {
+            const bool sampled = trial >= opts.warmups;
+            trial_sample sample;
+            auto [ok, emsg] = run_trial(
+                 &sample
+                ,impl
+                ,&counters
+                ,input_io.get()
+                ,output_io.get()
+                ,opts.json_flags
+                ,opts.cache
+                ,sampled ? &sampler : nullptr
+                ,opts.profile_phase
+            );
+            if ( !ok ) {
+                return {false, emsg};
+            }
+            // the ring buffer holds a few seconds of the samples
+            sampler.collect();
+        }
+        impl->release();
+    }
+
+    if ( sampler.lost() ) {
+        std::cerr << "  WARN: " << sampler.lost() << " samples of " << impl->variant_name()
+                  << " were lost because the ring buffer was full" << std::endl;
+    }
+
+    return sampler.write_folded(folded_fname, root);
+}
+
+// every measured trial is run in a fresh child process, which performs
+// the configured number of warmup trials first
+std::pair<bool, std::string> run_library_isolated_trials(
+     measurements *stat
+    ,benchmarks *impl
     ,const std::string &input_fname
-    ,const std::string &output_dir)
+    ,const benchmark_options &opts)
+{
+    auto child_opts = opts;
+    child_opts.iterations = 1;
+    child_opts.adaptive = false;
+
+    const auto start_ticks = phase_timer::now();
+    std::size_t next_check = opts.iterations;
+    for ( std::size_t trial = opts.warmups; need_more_trials(opts, *stat, trial, start_ticks, &next_check, &stat->converged); ++trial ) {
+        // the first child is enough for the allocations profile
+        child_opts.alloc_profile = opts.alloc_profile && trial == opts.warmups;
+
+        measurements child_stat;
+        auto res = run_isolated(&child_stat, [&](measurements *m) {
+            perf_group child_counters;
+
+            return run_library(m, impl, &child_counters, input_fname, child_opts);
+        });
+        if ( !res.first ) {
+            return res;
+        }
+
+        stat->merge_trials(child_stat);
+    }
+
+    return {true, std::string{}};
+}
+
+// the latency of the small documents, like the bodies of the API requests.
+// every trial is recorded, so the tail percentiles are reported instead of the averages.
+// the trials of one library run in the current process whatever the isolation mode is
+bool benchmark_small_files(
+     const benchmarks_list &implementations
+    ,const std::string &report_fname
+    ,const std::vector<std::string> &input_fnames
+    ,std::size_t iterations
+    ,const benchmark_options &opts)
 {
     try {
-        std::ofstream os("report/performance_small_file_text_array.md");
+        std::ofstream os{report_fname};
         os << std::endl;
-        os << "## Read and Write Time Comparison" << std::endl << std::endl;
+        os << "## Small Documents Latency" << std::endl << std::endl;
         os << std::endl;
-        os << "Input filename|Size (bytes)|Content" << std::endl;
+        os << "Input filename|Size (bytes)|JSON values" << std::endl;
         os << "---|---|---" << std::endl;
-        os << input_fname << "|" << file_size(input_fname.c_str()) << "|" << "Text,integers" << std::endl;
-        os << std::endl;
-        os << "Environment"
-           << "|" << get_os_type() << ", " << get_cpu_type() << std::endl;
-        os << "---|---" << std::endl;
-        os << "Computer"
-           << "|" << get_motherboard() << ", " << get_cpu() << ", " << get_ram() << std::endl;
-        os << "Operating system"
-           << "|" << get_os() << std::endl;
-        os << "Compiler"
-           << "|" << get_compiler() << std::endl;
-        os << std::endl;
-
-        os << "Library|Version" << std::endl;
-        os << "---|---" << std::endl;
-        for (const auto& val : implementations)
+        for ( const auto &it: input_fnames ) {
+            os << it << "|" << file_size(it.c_str()) << "|" << count_json_values(it) << std::endl;
+        }
+        os << std::endl;
+        write_environment_info(os);
+        os << "Timer"
+           << "|" << clock_source_name(phase_timer::source())
+           << ", overhead " << phase_timer::overhead_ns() << " ns" << std::endl;
+        write_isolation_info(os, opts);
+        os << "Cache mode"
+           << "|" << opts.cache << std::endl;
+        // the branch predictors and the caches need more than a single warmup for the tiny inputs
+        const auto warmups = std::max(opts.warmups, iterations / 10);
+        os << "Trials"
+           << "|" << warmups << " warmup, " << iterations << " measured for each document" << std::endl;
+        os << std::endl;
+
+        write_libraries_info(os, implementations);
+        os << std::endl;
+
+        perf_group counters;
+        for ( const auto &input_fname: input_fnames ) {
+            std::cout << "  file: " << input_fname << std::endl;
+
+            os << "### " << fs::path{input_fname}.filename().string() << std::endl << std::endl;
+            os << "Library|Parse p50 us|Parse p99 us|Parse p99.9 us|Parse max us|Print p50 us|Print p99 us|Print p99.9 us|Print max us|Allocations on read|Allocations on write" << std::endl;
+            os << "---|---|---|---|---|---|---|---|---|---|---" << std::endl;
+
+            for ( const auto &impl: implementations ) {
+                if ( !impl->applicable(opts.json_flags) ) {
+                    continue;
+                }
+                std::cout << "    name: " << impl->variant_name() << "... " << std::flush;
+
+                auto [input_io, output_io] = impl->create_io(input_fname);
+                hdr_histogram parse_hist, print_hist;
+                trial_sample sample;
+                for ( std::size_t trial = 0; trial < warmups + iterations; ++trial ) {
+                    auto [ok, emsg] = run_trial(&sample, impl.get(), &counters, input_io.get(), output_io.get(), opts.json_flags | impl->options(), opts.cache);
+                    if ( !ok ) {
+                        std::cerr << std::endl << emsg << std::endl;
+
+                        return false;
+                    }
+                    if ( trial >= warmups ) {
+                        parse_hist.record(sample.parse.time);
+                        print_hist.record(sample.print.time);
+                    }
+                }
+                std::cout << "parse " << parse_hist << " ns; print " << print_hist << " ns" << std::endl;
+
+                auto us = [](std::uint64_t ns) { return ns / 1000.0; };
+                os
+                    << "[" << impl->variant_name() << "](" << impl->url() << ")"
+                    << "|" << us(parse_hist.value_at_percentile(50.0))
+                    << "|" << us(parse_hist.value_at_percentile(99.0))
+                    << "|" << us(parse_hist.value_at_percentile(99.9))
+                    << "|" << us(parse_hist.max())
+                    << "|" << us(print_hist.value_at_percentile(50.0))
+                    << "|" << us(print_hist.value_at_percentile(99.0))
+                    << "|" << us(print_hist.value_at_percentile(99.9))
+                    << "|" << us(print_hist.max())
+                    // the allocations are deterministic, so the last trial is representative
+                    << "|" << sample.parse.alloc.allocations
+                    << "|" << sample.print.alloc.allocations
+                    << std::endl
+                ;
+            }
+            os << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cout << "benchmarks error: " << e.what() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+// the batch parse of the newline-delimited log records, see e_data_generator_mode::ndjson.
+// the latency of each record is the time between the ticks the adapter takes after them.
+// the trials of one library run in the current process, see the options rejected in main().
+// the library which fails is reported with its error, the others still run
+bool benchmark_records(
+     const benchmarks_list &implementations
+    ,const std::string &report_fname
+    ,const std::string &input_fname
+    ,const benchmark_options &opts)
+{
+    try {
+        const auto fsize = file_size(input_fname.c_str());
+        std::size_t records = 0;
         {
-            os << "[" << val->name() << "](" << val->url() << ")" << "|" << val->version() << std::endl;
+            auto input_io = create_io(io_direction::input, io_type::mmap_streams, input_fname);
+            const auto pair = input_io->read_all();
+            for_each_record(pair.first, pair.second, [&records](const char *, std::size_t) {
+                ++records;
+
+                return true;
+            });
+        }
+
+        std::ofstream os{report_fname};
+        os << std::endl;
+        os << "## NDJSON Records" << std::endl << std::endl;
+        os << std::endl;
+        os << "Input filename|Size (bytes)|Records" << std::endl;
+        os << "---|---|---" << std::endl;
+        os << input_fname << "|" << fsize << "|" << records << std::endl;
+        os << std::endl;
+        write_environment_info(os);
+        os << "Timer"
+           << "|" << clock_source_name(phase_timer::source())
+           << ", overhead " << phase_timer::overhead_ns() << " ns" << std::endl;
+        write_isolation_info(os, opts);
+        os << "Cache mode"
+           << "|" << opts.cache << std::endl;
+        os << "Trials"
+           << "|" << opts.warmups << " warmup, " << opts.iterations << " measured, all the records in each" << std::endl;
+        os << std::endl;
+
+        write_libraries_info(os, implementations);
+        os << std::endl;
+
+        os << "Library|Median ms|Records/s|MB/s|Record p50 us|Record p99 us|Record p99.9 us|Record max us|Allocations per record" << std::endl;
+        os << "---|---|---|---|---|---|---|---|---" << std::endl;
+
+        // one more for the case the adapter ticks too often, which is reported as the error
+        std::vector<std::uint64_t> ticks_storage(records + 1);
+        bool failed = false;
+        for ( const auto &impl: implementations ) {
+            // the records parse doesn't depend on the options, so the default variants only
+            if ( !impl->supports_records() || impl->options() ) {
+                continue;
+            }
+            std::cout << "  name: " << impl->variant_name() << "... " << std::flush;
+
+            auto input_io = create_io(io_direction::input, impl->input_io_type(), input_fname);
+            impl->prepare_records(input_io.get(), opts.json_flags);
+
+            hdr_histogram record_hist;
+            std::vector<std::uint64_t> samples;
+            malloc_stat_vars alloc{};
+            std::string errmsg;
+            for ( std::size_t trial = 0; trial < opts.warmups + opts.iterations; ++trial ) {
+                if ( opts.cache == cache_mode::hot ) {
+                    make_input_hot(input_io.get());
+                } else if ( opts.cache == cache_mode::cold ) {
+                    make_input_cold(input_io.get());
+                }
+
+                record_ticks ticks{ticks_storage.data(), ticks_storage.size(), 0};
+                MALLOC_STAT_RESET_STAT(get_alloc_stat);
+                const auto start = impl->start_time();
+                auto res = impl->parse_records(input_io.get(), opts.json_flags, &ticks);
+                const auto time = impl->duration(start);
+                alloc = MALLOC_STAT_GET_STAT(get_alloc_stat);
+                if ( !res.first ) {
+                    errmsg = "finished with error: " + res.second;
+                    break;
+                }
+                if ( ticks.count != records ) {
+                    errmsg = "parsed " + std::to_string(ticks.count) + " of " + std::to_string(records) + " records";
+                    break;
+                }
+                if ( trial < opts.warmups ) {
+                    continue;
+                }
+
+                samples.push_back(time);
+                auto prev = start;
+                for ( std::size_t i = 0; i < ticks.count; ++i ) {
+                    record_hist.record(phase_timer::to_ns(ticks.ticks[i] - prev));
+                    prev = ticks.ticks[i];
+                }
+            }
+            impl->finish_records();
+            if ( !errmsg.empty() ) {
+                std::cerr << std::endl << "the RECORDS benchmark for \"" << impl->variant_name()
+                    << "\" " << errmsg << std::endl;
+                os
+                    << "[" << impl->variant_name() << "](" << impl->url() << ")"
+                    << "|" << errmsg << "|||||||"
+                    << std::endl
+                ;
+                failed = true;
+
+                continue;
+            }
+
+            const auto stats = compute_stats(samples, opts.bootstrap_resamples);
+            std::cout << "median " << human_time(stats.median) << ", record " << record_hist << " ns" << std::endl;
+
+            auto us = [](std::uint64_t ns) { return ns / 1000.0; };
+            const auto seconds = stats.median / 1e9;
+            os
+                << "[" << impl->variant_name() << "](" << impl->url() << ")"
+                << "|" << stats.median/1e6
+                << "|" << (seconds ? records / seconds : 0.0)
+                << "|" << (seconds ? (fsize / 1000000.0) / seconds : 0.0)
+                << "|" << us(record_hist.value_at_percentile(50.0))
+                << "|" << us(record_hist.value_at_percentile(99.0))
+                << "|" << us(record_hist.value_at_percentile(99.9))
+                << "|" << us(record_hist.max())
+                // the allocations are deterministic, so the last trial is representative
+                << "|" << (records ? static_cast<double>(alloc.allocations) / records : 0.0)
+                << std::endl
+            ;
+        }
+        os << std::endl;
+
+        return !failed;
+    } catch (const std::exception &e) {
+        std::cout << "benchmarks error: " << e.what() << std::endl;
+
+        return false;
+    }
+}
+
+// the throughput of each library parsing and printing on 1..N threads at once.
+// the efficiency is the speedup over a single thread divided by the number of the threads
+bool benchmark_scaling(
+     const benchmarks_list &implementations
+    ,const std::string &report_fname
+    ,const std::string &input_fname
+    ,std::size_t max_threads
+    ,const std::vector<placement_policy> &policies
+    ,bool shared_input
+    ,const benchmark_options &opts)
+{
+    try {
+        std::vector<std::size_t> steps;
+        for ( std::size_t n = 1; n < max_threads; n *= 2 ) {
+            steps.push_back(n);
+        }
+        steps.push_back(max_threads);
+
+        std::ofstream os{report_fname};
+        os << std::endl;
+        os << "## Multi-threaded Scaling" << std::endl << std::endl;
+        os << std::endl;
+        os << "Input filename|Size (MB)|JSON values" << std::endl;
+        os << "---|---|---" << std::endl;
+        os << input_fname << "|" << (file_size(input_fname.c_str())/1000000.0) << "|" << count_json_values(input_fname) << std::endl;
+        os << std::endl;
+        write_environment_info(os);
+        os << "CPUs available"
+           << "|" << get_cpu_topology().size() << std::endl;
+        os << "Input"
+           << "|" << (shared_input ? "one mapping shared by the threads" : "mapped by each thread") << std::endl;
+        os << "Trials"
+           << "|" << opts.warmups << " warmup, " << opts.iterations << " measured by each thread" << std::endl;
+        os << std::endl;
+
+        write_libraries_info(os, implementations);
+        os << std::endl;
+
+        scaling_options sopts;
+        sopts.warmups = opts.warmups;
+        sopts.iterations = opts.iterations;
+        sopts.json_flags = opts.json_flags;
+        sopts.shared_input = shared_input;
+
+        for ( auto policy: policies ) {
+            sopts.placement = policy;
+            const auto order = placement_order(policy, get_cpu_topology());
+
+            os << "### Placement: " << policy << std::endl << std::endl;
+            os << "CPUs in order of use: ";
+            for ( auto i = 0u; i < order.size(); ++i ) {
+                os << (i ? ", " : "") << order[i];
+            }
+            if ( policy == placement_policy::bandwidth ) {
+                os << "; the CPUs not running the library stream through 16 MB buffers";
+            }
+            os << std::endl << std::endl;
+
+            for ( const auto &impl: implementations ) {
+                if ( !impl->applicable(opts.json_flags) ) {
+                    continue;
+                }
+                std::cout << "  " << policy << ", name: " << impl->variant_name() << std::endl;
+                sopts.json_flags = opts.json_flags | impl->options();
+
+                os << "#### " << impl->variant_name() << std::endl << std::endl;
+                os << "Threads|Parse MB/s|Parse speedup|Parse efficiency %|Print MB/s|Print speedup|Print efficiency %|Parse median ms|Print median ms" << std::endl;
+                os << "---|---|---|---|---|---|---|---|---" << std::endl;
+
+                scaling_point single{};
+                for ( auto threads: steps ) {
+                    std::cout << "    " << threads << " threads... " << std::flush;
+                    scaling_point point{};
+                    auto [ok, emsg] = run_scaling_step(&point, impl.get(), input_fname, threads, sopts);
+                    if ( !ok ) {
+                        std::cerr << std::endl << emsg << std::endl;
+
+                        return false;
+                    }
+                    if ( threads == 1 ) {
+                        single = point;
+                    }
+                    std::cout << "parse " << point.parse_mbs << " MB/s, print " << point.print_mbs << " MB/s" << std::endl;
+
+                    const auto parse_speedup = single.parse_mbs ? point.parse_mbs / single.parse_mbs : 0.0;
+                    const auto print_speedup = single.print_mbs ? point.print_mbs / single.print_mbs : 0.0;
+                    os
+                        << threads
+                        << "|" << point.parse_mbs
+                        << "|" << parse_speedup
+                        << "|" << (parse_speedup / threads * 100.0)
+                        << "|" << point.print_mbs
+                        << "|" << print_speedup
+                        << "|" << (print_speedup / threads * 100.0)
+                        << "|" << (point.parse_median_ns / 1000000.0)
+                        << "|" << (point.print_median_ns / 1000000.0)
+                        << std::endl
+                    ;
+                }
+                os << std::endl;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cout << "benchmarks error: " << e.what() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+// the library which fails is reported with its error and left out of the results,
+// the others still run. returns false if any of them failed
+bool benchmark(
+     const benchmarks_list &implementations
+    ,const std::string &report_fname
+    ,const std::string &input_fname
+    ,const std::string &output_dir
+    ,const benchmark_options &opts
+    ,bool *regressed)
+{
+    try {
+        auto fsize = file_size(input_fname.c_str());
+        auto json_values = count_json_values(input_fname);
+        const auto suite = fs::path{report_fname}.stem().string();
+
+        std::ofstream os{report_fname};
+        os << std::endl;
+        os << "## Read and Write Time Comparison" << std::endl << std::endl;
+        os << std::endl;
+        os << "Input filename|Size (MB)|JSON values|Content" << std::endl;
+        os << "---|---|---|---" << std::endl;
+        os << input_fname << "|" << (fsize/1000000.0) << "|" << json_values << "|" << "Text,doubles" << std::endl;
+        os << std::endl;
+        write_environment_info(os);
+        os << "Timer"
+           << "|" << clock_source_name(phase_timer::source());
+        if ( phase_timer::source() == clock_source::tsc ) {
+            os << " @ " << (phase_timer::tsc_hz()/1000000.0) << " MHz";
+        }
+        os << ", overhead " << phase_timer::overhead_ns() << " ns" << std::endl;
+        write_isolation_info(os, opts);
+        os << "Process isolation"
+           << "|" << opts.isolation << std::endl;
+        os << "Cache mode"
+           << "|" << opts.cache;
+        if ( opts.cache == cache_mode::cold ) {
+            const auto llc = get_llc_size();
+            os << ", page cache dropped and ";
+            if ( llc ) {
+                os << (llc * 2 / 1024) << " KB swept";
+            } else {
+                os << "64 MB swept (LLC size is unknown)";
+            }
+            os << " before each parse";
+        } else if ( opts.cache == cache_mode::hot ) {
+            os << ", input prefaulted and parsed untimed before the measurements";
+        }
+        os << std::endl;
+        os << "Allocations profile"
+           << "|";
+        if ( !opts.alloc_profile ) {
+            os << "disabled";
+        } else if ( !alloc_tracker::available() ) {
+            os << "n/a (malloc() is not intercepted)";
+        } else {
+            os << "one extra untimed trial";
+            if ( opts.alloc_sites ) {
+                os << ", top " << opts.alloc_sites << " call stacks of parse and print";
+            }
+            if ( opts.alloc_timeline ) {
+                os << ", live bytes timeline each " << opts.alloc_timeline
+                   << " allocations in " << output_dir << "/alloc_timeline_*.csv";
+            }
+        }
+        os << std::endl;
+        os << "Sampling profile"
+           << "|";
+        if ( opts.profile_library.empty() ) {
+            os << "disabled";
+        } else {
+            os << opts.profile_library << ", " << trial_phase_name(opts.profile_phase) << " at "
+               << opts.profile_frequency << " Hz in the extra untimed trials, "
+               << output_dir << "/profile_" << suite << "_*.folded";
+        }
+        os << std::endl;
+        os << "Allocators"
+           << "|";
+        for ( const auto &it: opts.allocators ) {
+            os << (&it == &opts.allocators.front() ? "" : ", ") << it;
+        }
+        os << ", the libraries accepting the user allocator only, the suffix of the library name" << std::endl;
+        os << "Reuse mode"
+           << "|" << (opts.reuse ? "the libraries supporting it also keep the parser/document across the trials, the 'reuse' suffix" : "disabled")
+           << std::endl;
+        os << "SAX parse"
+           << "|" << (opts.sax ? "the event API of the libraries supporting it, measured in the separate trials" : "disabled")
+           << std::endl;
+        os << "Chunked input"
+           << "|";
+        if ( opts.chunk_sizes.empty() ) {
+            os << "disabled";
+        } else {
+            for ( const auto &it: opts.chunk_sizes ) {
+                os << (&it == &opts.chunk_sizes.front() ? "" : ", ") << human_size(it);
+            }
+            os << " chunks of the mapped input fed to the incremental parsers supporting it";
+        }
+        os << std::endl;
+        os << "Traverse"
+           << "|" << (opts.traverse ? "the reads of the parsed document by the libraries supporting it, measured in the separate trials" : "disabled")
+           << std::endl;
+        os << "I/O devices"
+           << "|" << (opts.io_matrix
+                ? "each input/output pair the library supports, the 'input>output' suffix for the non-default ones"
+                : "the default ones of the library")
+           << std::endl;
+        os << "Trials"
+           << "|" << opts.warmups << " warmup, " << opts.iterations << " measured";
+        if ( opts.adaptive ) {
+            os << " at least, adaptive until CI of median is within +/-" << (opts.target_ci * 100.0)
+               << "%, at most " << opts.max_iterations << " trials or " << (opts.time_budget_ns / 1e9) << " s";
+        }
+        os << std::endl;
+        os << std::endl;
+
+        write_libraries_info(os, implementations);
+        os << std::endl;
+
+        perf_group counters;
+        if ( !counters.available() ) {
+            std::cerr << "  WARN: hardware performance counters are not available: " << counters.error() << std::endl;
+        }
+
+        // each library with each allocator it supports, with and without the reuse,
+        // and with each pair of the I/O devices in the matrix mode, is the separate row
+        std::vector<std::tuple<benchmarks *, allocator_kind, bool, io_type, io_type>> runs;
+        // the libraries having the registered reuse variant don't need the extra reuse run
+        std::set<std::string> reuse_variants;
+        for ( const auto &impl: implementations ) {
+            if ( impl->options() & e_json_flags::reuse ) {
+                reuse_variants.insert(impl->name());
+            }
+        }
+        for ( const auto &impl: implementations ) {
+            if ( !impl->applicable(opts.json_flags) ) {
+                continue;
+            }
+            std::vector<std::pair<io_type, io_type>> devices{{impl->input_io_type(), impl->output_io_type()}};
+            if ( opts.io_matrix ) {
+                devices.clear();
+                for ( const auto &in: impl->input_io_types() ) {
+                    for ( const auto &out: impl->output_io_types() ) {
+                        devices.emplace_back(in, out);
+                    }
+                }
+            }
+            for ( const auto &kind: opts.allocators ) {
+                if ( !impl->supports_allocator(kind) ) {
+                    continue;
+                }
+                for ( const auto &[in, out]: devices ) {
+                    runs.emplace_back(impl.get(), kind, false, in, out);
+                    if ( opts.reuse && impl->supports_reuse() && !reuse_variants.count(impl->name()) ) {
+                        runs.emplace_back(impl.get(), kind, true, in, out);
+                    }
+                }
+            }
+        }
+
+        benchmark_results results;
+        // the names and the errors of the failed runs
+        std::vector<std::pair<std::string, std::string>> failures;
+        std::set<std::string> profiled;
+        // the sax, chunked and traverse trials don't depend on the devices and the reuse mode,
+        // so they run once for each variant, with its default devices and its first allocator
+        std::set<const benchmarks *> extras_done;
+        for ( const auto &[impl, kind, reuse, input_io, output_io]: runs ) {
+            measurements stat;
+            stat.name = impl->variant_name();
+            std::string tags;
+            if ( kind != allocator_kind::system ) {
+                tags += allocator_kind_name(kind);
+            }
+            if ( reuse ) {
+                tags += tags.empty() ? "reuse" : ", reuse";
+            }
+            if ( input_io != impl->input_io_type() || output_io != impl->output_io_type() ) {
+                tags += tags.empty() ? "" : ", ";
+                tags += std::string{io_type_name(input_io)} + ">" + io_type_name(output_io);
+            }
+            if ( !tags.empty() ) {
+                stat.name += " [" + tags + "]";
+            }
+            std::cout << "  name: " << stat.name << std::endl;
+            set_allocator(kind);
+            auto run_opts = opts;
+            run_opts.json_flags |= impl->options();
+            if ( reuse ) {
+                run_opts.json_flags |= e_json_flags::reuse;
+            }
+            run_opts.input_io = input_io;
+            run_opts.output_io = output_io;
+            const bool default_devices = input_io == impl->input_io_type() && output_io == impl->output_io_type();
+            if ( reuse || !default_devices || !extras_done.insert(impl).second ) {
+                run_opts.sax = false;
+                run_opts.chunk_sizes.clear();
+                run_opts.traverse = false;
+            }
+            stat.warmups = opts.warmups;
+            stat.input_size = fsize;
+            stat.json_values = json_values;
+
+            std::cout
+                << "    running " << opts.warmups << " warmup and "
+                << (opts.adaptive ? "at least " : "")
+                << opts.iterations << " measured trials"
+                << (opts.isolation != isolation_mode::none ? " in child processes" : "")
+                << "... " << std::flush
+            ;
+
+            std::pair<bool, std::string> res;
+            switch ( opts.isolation ) {
+                case isolation_mode::none: {
+                    res = run_library(&stat, impl, &counters, input_fname, run_opts);
+                    break;
+                }
+                case isolation_mode::library: {
+                    res = run_isolated(&stat, [&](measurements *m) {
+                        *m = stat;
+                        perf_group child_counters;
+
+                        return run_library(m, impl, &child_counters, input_fname, run_opts);
+                    });
+                    break;
+                }
+                case isolation_mode::trial: {
+                    res = run_library_isolated_trials(&stat, impl, input_fname, run_opts);
+                    break;
+                }
+            }
+            if ( !res.first ) {
+                std::cerr << std::endl << res.second << std::endl;
+                failures.emplace_back(stat.name, res.second);
+
+                continue;
+            }
+            std::cout << "done, " << stat.parse_samples.size() << " measured";
+            if ( opts.adaptive ) {
+                std::cout << (stat.converged ? ", converged" : ", NOT converged");
+            }
+            std::cout << std::endl;
+
+            const auto measured = stat.parse_samples.size();
+            stat.prepare_counters /= measured;
+            stat.parse_counters /= measured;
+            stat.print_counters /= measured;
+            stat.free_counters /= measured;
+            stat.prepare_usage /= measured;
+            stat.parse_usage /= measured;
+            stat.print_usage /= measured;
+            stat.free_usage /= measured;
+
+            stat.prepare_stats = compute_stats(stat.prepare_samples, opts.bootstrap_resamples);
+            stat.parse_stats = compute_stats(stat.parse_samples, opts.bootstrap_resamples);
+            stat.print_stats = compute_stats(stat.print_samples, opts.bootstrap_resamples);
+            stat.free_stats = compute_stats(stat.free_samples, opts.bootstrap_resamples);
+            stat.time_to_prepare = stat.prepare_stats.median;
+            stat.time_to_parse = stat.parse_stats.median;
+            stat.time_to_print = stat.print_stats.median;
+            stat.time_to_free = stat.free_stats.median;
+            if ( !stat.sax_parse_samples.empty() ) {
+                stat.sax_parse_stats = compute_stats(stat.sax_parse_samples, opts.bootstrap_resamples);
+                stat.time_to_sax_parse = stat.sax_parse_stats.median;
+            }
+            for ( auto &it: stat.chunked ) {
+                it.stats = compute_stats(it.samples, opts.bootstrap_resamples);
+                it.compute_percentiles();
+            }
+            for ( auto &it: stat.traversed ) {
+                it.stats = compute_stats(it.samples, opts.bootstrap_resamples);
+            }
+
+            std::cout << stat;
+
+            auto allowed_leaks = impl->allowed_leaks();
+            if ( !stat.leaks_as_expected ) {
+                std::cerr
+                    << "  WARN: leaked memory suspicion ("
+                    << stat.free_leaked_bytes << " bytes, "
+                    << stat.free_leaked_allocations << " in blocks)"
+                << std::endl;
+            } else {
+                if ( allowed_leaks.first ) {
+                    std::cerr << " (as expected!)" << std::endl;
+                } else {
+                    std::cerr << std::endl;
+                }
+            }
+
+            // the sampling would disturb the measurements, so it's done in the separate trials
+            const auto variant = impl->variant_name();
+            const bool profile = opts.profile_library == variant || opts.profile_library == "all";
+            if ( profile && profiled.insert(variant).second ) {
+                const auto root = variant + " " + trial_phase_name(opts.profile_phase);
+                const auto folded_fname = output_dir + "/profile_" + suite + "_" + variant
+                    + "_" + trial_phase_name(opts.profile_phase) + ".folded";
+                std::cout << "    profiling " << root << " into " << folded_fname << "... " << std::flush;
+
+                std::pair<bool, std::string> res;
+                if ( opts.isolation == isolation_mode::none ) {
+                    res = profile_library(impl, input_fname, folded_fname, root, run_opts);
+                } else {
+                    measurements unused;
+                    res = run_isolated(&unused, [&](measurements *) {
+                        return profile_library(impl, input_fname, folded_fname, root, run_opts);
+                    });
+                }
+                if ( res.first ) {
+                    std::cout << "done" << std::endl;
+                } else {
+                    std::cout << std::endl;
+                    std::cerr << "  WARN: " << res.second << std::endl;
+                }
+            }
+
+            // when we are faced with JSON test mismatch - there is no reason
+            // for inclusion that test results into the report...
+            if ( 0 /*!check_res.first*/ ) {
+                std::cerr
+                    << "  WARN: the comparison test for the SOURCE and GENERATED JSON was failed with error: " << "check_res.second" << "\"\n"
+                    << "  the results of that test will not be included into the report!"
+                << std::endl;
+            } else {
+                results.emplace_back(impl, std::move(stat));
+            }
+        }
+        set_allocator(allocator_kind::system);
+
+        // the peak is the high-water mark of the live bytes allocated since the trial start,
+        // so the memory allocated by prepare() and still alive is included
+        auto peak_mb = [](const alloc_profile &p) -> std::string {
+            return p.collected ? std::to_string(p.peak_live_bytes/1000000.0) : std::string{"n/a"};
+        };
+        os << "Library|Time to read s|Time to write s|Memory footprint on read MB|Memory footprint on write MB|Peak memory on read MB|Peak memory on write MB|Allocations on read|Allocations on write|Remarks" << std::endl;
+        os << "---|---|---|---|---|---|---|---|---|---" << std::endl;
+        for ( const auto &[impl, stat]: results ) {
+            os
+                << "[" << stat.name << "](" << impl->url() << ")"
+                << "|" << stat.time_to_parse/1e9
+                << "|" << stat.time_to_print/1e9
+                << "|" << stat.parse_allocated/1000000.0
+                << "|" << stat.print_allocated/1000000.0
+                << "|" << peak_mb(stat.parse_alloc_profile)
+                << "|" << peak_mb(stat.print_alloc_profile)
+                << "|" << stat.parse_allocations
+                << "|" << stat.print_allocations
+                << "|" << impl->notes()
+                << std::endl
+            ;
         }
         os << std::endl;
 
-        os << "Library|Time to read ms|Time to write ms|Memory footprint on read|Memory footprint on write|Allocations on read|Allocations on write|Remarks" << std::endl;
-        os << "---|---|---|---|---|---|---|---" << std::endl;
-
-        std::vector<measurements> measurements_res(implementations.size());
+        os << "Library|Parse MB/s|Print MB/s|Parse cycles/byte|Print cycles/byte|Parse ns/value|Print ns/value" << std::endl;
+        os << "---|---|---|---|---|---|---" << std::endl;
+        // neither the cycles counter nor the TSC is available under the monotonic clock fallback
+        auto cycles = [&os](const perf_counters &c, double v) {
+            if ( !c.is_valid(perf_event::cycles) && !phase_timer::tsc_hz() ) {
+                return std::string{"n/a"};
+            }
+            std::ostringstream ss;
+            ss.flags(os.flags());
+            ss.precision(os.precision());
+            ss << v;
+
+            return ss.str();
+        };
+        for ( const auto &[impl, stat]: results ) {
+            os
+                << stat.name
+                << "|" << stat.parse_throughput()
+                << "|" << stat.print_throughput()
+                << "|" << cycles(stat.parse_counters, stat.parse_cycles_per_byte(phase_timer::tsc_hz()))
+                << "|" << cycles(stat.print_counters, stat.print_cycles_per_byte(phase_timer::tsc_hz()))
+                << "|" << stat.parse_ns_per_value()
+                << "|" << stat.print_ns_per_value()
+                << std::endl
+            ;
+        }
+        if ( !counters.available() ) {
+            os << std::endl << "cycles/byte are TSC reference cycles, the hardware counters are not available" << std::endl;
+        }
+        os << std::endl;
 
-        for (size_t i = 0; i < iter_times; ++i) {
-            for (size_t j = 0; j < implementations.size(); ++j) {
-                auto &impl = implementations[j];
-                auto output_fname = output_dir;
-                output_fname += "/";
-                output_fname += output_fname_prefix;
-                output_fname += impl->name();
-                output_fname += ".json";
+        // the first trial pays for the setup, the steady state is the median of the measured trials
+        os << "Library|First prepare+parse ms|Steady prepare+parse ms|First allocations|Steady allocations|First allocated MB|Steady allocated MB" << std::endl;
+        os << "---|---|---|---|---|---|---" << std::endl;
+        for ( const auto &[impl, stat]: results ) {
+            os
+                << stat.name
+                << "|" << stat.first_trial_time/1e6
+                << "|" << (stat.time_to_prepare + stat.time_to_parse)/1e6
+                << "|" << stat.first_trial_allocations
+                << "|" << (stat.prepare_allocations + stat.parse_allocations)
+                << "|" << stat.first_trial_allocated/1000000.0
+                << "|" << (stat.prepare_allocated + stat.parse_allocated)/1000000.0
+                << std::endl
+            ;
+        }
+        os << std::endl;
 
-                auto input_io = create_input(impl->input_io_type(), input_fname);
-                auto output_io = create_output(impl->output_io_type(), output_fname);
+        // the visitors count the same events, so the differing counts point to a bug in the adapter
+        if ( opts.sax ) {
+            os << "Library|SAX parse ms|DOM parse ms|SAX parse MB/s|SAX allocations|SAX allocated MB|Events|Sum of numbers" << std::endl;
+            os << "---|---|---|---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                if ( stat.sax_parse_samples.empty() ) {
+                    continue;
+                }
+                os
+                    << stat.name
+                    << "|" << stat.time_to_sax_parse/1e6
+                    << "|" << stat.time_to_parse/1e6
+                    << "|" << stat.sax_parse_throughput()
+                    << "|" << stat.sax_parse_allocations
+                    << "|" << stat.sax_parse_allocated/1000000.0
+                    << "|" << stat.sax_events
+                    << "|" << stat.sax_numbers
+                    << std::endl
+                ;
+            }
+            os << std::endl;
+        }
 
-                auto results = impl->measure(*input_io, *output_io);
-                if ( !results.errmsg.empty() ) {
-                    std::cerr << "the benchmark for \"" << results.name << "\" was failed with error: "
-                              << results.errmsg << std::endl
+        // the resumption overhead is the difference with the whole-buffer parse
+        if ( !opts.chunk_sizes.empty() ) {
+            os << "Library|Chunk size|Chunked parse ms|Whole parse ms|Chunked parse MB/s|Chunk p50 us|Chunk p99 us|Chunk max us|Allocations" << std::endl;
+            os << "---|---|---|---|---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                for ( const auto &it: stat.chunked ) {
+                    os
+                        << stat.name
+                        << "|" << human_size(it.chunk_size)
+                        << "|" << it.stats.median/1e6
+                        << "|" << stat.time_to_parse/1e6
+                        << "|" << it.throughput(stat.input_size)
+                        << "|" << it.chunk_p50/1e3
+                        << "|" << it.chunk_p99/1e3
+                        << "|" << it.chunk_max/1e3
+                        << "|" << it.allocations
+                        << std::endl
                     ;
-
-                    return false;
                 }
+            }
+            os << std::endl;
+        }
 
-                measurements_res[j].read_memory_used += results.read_memory_used;
-                measurements_res[j].read_allocations += results.read_allocations;
-                measurements_res[j].write_memory_used += results.write_memory_used;
-                measurements_res[j].write_allocations += results.write_allocations;
-                measurements_res[j].time_to_read += results.time_to_read;
-                measurements_res[j].time_to_write += results.time_to_write;
+        // the libraries read the same values, so the differing totals point to a bug in the adapter
+        if ( opts.traverse ) {
+            os << "Library|Pattern|Traverse ms|Parse ms|ns/value|Allocations|Values|String bytes|Sum of numbers" << std::endl;
+            os << "---|---|---|---|---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                for ( const auto &it: stat.traversed ) {
+                    os
+                        << stat.name
+                        << "|" << traverse_pattern_name(static_cast<traverse_pattern>(it.pattern))
+                        << "|" << it.stats.median/1e6
+                        << "|" << stat.time_to_parse/1e6
+                        << "|" << it.ns_per_value()
+                        << "|" << it.allocations
+                        << "|" << it.values
+                        << "|" << it.strings
+                        << "|" << it.numbers
+                        << std::endl
+                    ;
+                }
             }
+            os << std::endl;
         }
 
-        for (size_t j = 0; j < measurements_res.size(); ++j) {
-            auto &it = measurements_res[j];
-            os << it.name
-            << "|" << it.time_to_read/(iter_times)
-            << "|" << it.time_to_write/(iter_times)
-            << "|" << it.read_memory_used/iter_times
-            << "|" << it.write_memory_used/iter_times
-            << "|" << it.read_allocations/iter_times
-            << "|" << it.write_allocations/iter_times
-            << "|" << implementations[j]->notes()
-            << std::endl;
+        os << "Library|Phase|Min ms|Median ms|Mean ms|p90 ms|p99 ms|Stddev ms|MAD ms|95% CI of median ms|Outliers" << std::endl;
+        os << "---|---|---|---|---|---|---|---|---|---|---" << std::endl;
+        for ( const auto &[impl, stat]: results ) {
+            const std::pair<const char *, const sample_stats *> phases[] = {
+                 {"prepare", &stat.prepare_stats}
+                ,{"parse", &stat.parse_stats}
+                ,{"print", &stat.print_stats}
+                ,{"free", &stat.free_stats}
+            };
+            for ( const auto &[phase, s]: phases ) {
+                os
+                    << stat.name
+                    << "|" << phase
+                    << "|" << s->min/1e6
+                    << "|" << s->median/1e6
+                    << "|" << s->mean/1e6
+                    << "|" << s->p90/1e6
+                    << "|" << s->p99/1e6
+                    << "|" << s->stddev/1e6
+                    << "|" << s->mad/1e6
+                    << "|" << s->ci_low/1e6 << " .. " << s->ci_high/1e6
+                    << "|" << s->outliers << "/" << (s->count + s->outliers)
+                    << std::endl
+                ;
+            }
         }
         os << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "benchmarks_small_file: what: " << e.what() << std::endl;
-
-        return false;
-    }
-
-    return true;
-}
-#endif // SMALL_FILE_TEST_ENABLED
-
-/*************************************************************************************************/
-
-bool benchmark(
-     const benchmarks_list &implementations
-    ,const std::string &report_fname
-    ,const std::string &input_fname
-    ,const std::string &output_dir
-    ,std::size_t json_flags)
-{
-    try {
-        auto fsize = file_size(input_fname.c_str());
 
-        std::ofstream os{report_fname};
-        os << std::endl;
-        os << "## Read and Write Time Comparison" << std::endl << std::endl;
-        os << std::endl;
-        os << "Input filename|Size (MB)|Content" << std::endl;
-        os << "---|---|---" << std::endl;
-        os << input_fname << "|" << (fsize/1000000.0) << "|" << "Text,doubles" << std::endl;
-        os << std::endl;
-        os << "Environment"
-           << "|" << get_os_type() << ", " << get_cpu_type() << std::endl;
-        os << "---|---" << std::endl;
-        os << "Computer"
-           << "|" << get_motherboard() << ", " << get_cpu() << ", " << get_ram() << std::endl;
-        os << "Operating system"
-           << "|" << get_os() << std::endl;
-        os << "Compiler"
-           << "|" << get_compiler() << std::endl;
+        if ( counters.available() ) {
+            os << "Library|Phase|Cycles|Instructions|IPC|Branch misses|L1D misses|LLC misses|dTLB misses|LLC misses per KB" << std::endl;
+            os << "---|---|---|---|---|---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                const std::pair<const char *, const perf_counters *> phases[] = {
+                     {"prepare", &stat.prepare_counters}
+                    ,{"parse", &stat.parse_counters}
+                    ,{"print", &stat.print_counters}
+                    ,{"free", &stat.free_counters}
+                };
+                for ( const auto &[phase, c]: phases ) {
+                    auto value = [c=c](perf_event ev) -> std::string {
+                        return c->is_valid(ev) ? std::to_string(c->get(ev)) : std::string{"n/a"};
+                    };
+                    os
+                        << stat.name
+                        << "|" << phase
+                        << "|" << value(perf_event::cycles)
+                        << "|" << value(perf_event::instructions)
+                        << "|" << c->ipc()
+                        << "|" << value(perf_event::branch_misses)
+                        << "|" << value(perf_event::l1d_misses)
+                        << "|" << value(perf_event::llc_misses)
+                        << "|" << value(perf_event::dtlb_misses)
+                        << "|"
+                    ;
+                    if ( c->is_valid(perf_event::llc_misses) ) {
+                        os << c->get(perf_event::llc_misses) / (fsize / 1024.0);
+                    } else {
+                        os << "n/a";
+                    }
+                    os << std::endl;
+                }
+            }
+        } else {
+            os << "Hardware counters|n/a (" << counters.error() << ")" << std::endl;
+        }
         os << std::endl;
 
-        os << "Library|Version" << std::endl;
-        os << "---|---" << std::endl;
-        for ( const auto& val : implementations ) {
-            os << "[" << val->name() << "](" << val->url() << ")" << "|" << val->version() << std::endl;
+        os << "Library|Phase|Minor faults|Major faults|User ms|Sys ms|Voluntary switches|Involuntary switches|RSS before MB|RSS after MB" << std::endl;
+        os << "---|---|---|---|---|---|---|---|---|---" << std::endl;
+        for ( const auto &[impl, stat]: results ) {
+            const std::pair<const char *, const resource_usage *> phases[] = {
+                 {"prepare", &stat.prepare_usage}
+                ,{"parse", &stat.parse_usage}
+                ,{"print", &stat.print_usage}
+                ,{"free", &stat.free_usage}
+            };
+            for ( const auto &[phase, u]: phases ) {
+                os
+                    << stat.name
+                    << "|" << phase
+                    << "|" << u->minor_faults
+                    << "|" << u->major_faults
+                    << "|" << u->user_time_ns/1e6
+                    << "|" << u->sys_time_ns/1e6
+                    << "|" << u->voluntary_switches
+                    << "|" << u->involuntary_switches
+                    << "|" << u->rss_before/1000000.0
+                    << "|" << u->rss_after/1000000.0
+                    << std::endl
+                ;
+            }
         }
         os << std::endl;
 
-        os << "Library|Time to read s|Time to write s|Memory footprint on read MB|Memory footprint on write MB|Allocations on read|Allocations on write|Remarks" << std::endl;
-        os << "---|---|---|---|---|---|---|---" << std::endl;
-
-        for ( const auto &impl: implementations ) {
-            std::cout << "  name: " << impl->name() << std::endl;
-
-            measurements stat;
-            stat.name = impl->name();
-
-            auto [input_io, output_io] = impl->create_io(input_fname);
-            output_io->reserve(input_io->size() * 2);
-
-            ///////////////////////////////////////////////////////// prepare
-            std::cout << "    prepairing... " << std::flush;
-
-            auto prepare_start = impl->start_time();
-            MALLOC_STAT_RESET_STAT(get_alloc_stat);
-
-            impl->prepare(input_io.get(), json_flags);
-
-            malloc_stat_vars prepare_stat = MALLOC_STAT_GET_STAT(get_alloc_stat);
-            auto prepare_time = impl->duration(prepare_start);
-
-            std::cout << "done" << std::endl;
-            ///////////////////////////////////////////////////////// parse
-            std::cout << "    parsing... " << std::flush;
-
-            auto parse_start = impl->start_time();
-            MALLOC_STAT_RESET_STAT(get_alloc_stat);
+        if ( opts.alloc_profile && alloc_tracker::available() ) {
+            os << "Library|Phase|Allocations|Freed in trial|Live at start MB|Peak live MB|Size classes|Lifetimes of freed blocks" << std::endl;
+            os << "---|---|---|---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                const std::pair<const char *, const alloc_profile *> phases[] = {
+                     {"prepare", &stat.prepare_alloc_profile}
+                    ,{"parse", &stat.parse_alloc_profile}
+                    ,{"print", &stat.print_alloc_profile}
+                    ,{"free", &stat.free_alloc_profile}
+                };
+                for ( const auto &[phase, p]: phases ) {
+                    os
+                        << stat.name
+                        << "|" << phase
+                        << "|" << p->allocations
+                        << "|" << p->freed
+                        << "|" << p->live_at_start/1000000.0
+                        << "|" << p->peak_live_bytes/1000000.0
+                        << "|" << p->size_histogram_str()
+                        << "|" << p->lifetime_histogram_str()
+                        << std::endl
+                    ;
+                }
+            }
+            os << std::endl;
+        }
 
-            auto [parse_ok, parse_err] = impl->parse(input_io.get(), json_flags);
-            if ( !parse_ok ) {
-                stat.errmsg = parse_err;
+        for ( const auto &[impl, stat]: results ) {
+            if ( stat.alloc_timeline.empty() ) {
+                continue;
+            }
 
-                std::cerr
+            auto tag = stat.name;
+            for ( auto &ch: tag ) {
+                ch = std::isalnum(static_cast<unsigned char>(ch)) ? ch : '_';
+            }
+            const auto fname = output_dir + "/alloc_timeline_" + tag + ".csv";
+            std::ofstream timeline{fname};
+            timeline << "allocation,phase,live_bytes" << std::endl;
+            for ( const auto &it: stat.alloc_timeline ) {
+                timeline
+                    << it.allocation
+                    << "," << trial_phase_name(static_cast<trial_phase>(it.phase))
+                    << "," << it.live_bytes
                     << std::endl
-                    << "the PARSE benchmark for \"" << impl->name() << "\" finished with error: "
-                    << parse_err << std::endl
                 ;
-
-                return false;
             }
+        }
 
-            malloc_stat_vars parse_stat = MALLOC_STAT_GET_STAT(get_alloc_stat);
-            auto parse_time = impl->duration(parse_start);
-
-            std::cout << "done" << std::endl;
-            ///////////////////////////////////////////////////////// print
-            std::cout << "    printing... " << std::flush;
-
-            auto print_start = impl->start_time();
-            MALLOC_STAT_RESET_STAT(get_alloc_stat);
-
-            if ( parse_ok ) {
-                auto [print_ok, print_err] = impl->print(output_io.get(), json_flags);
-                if ( !print_ok ) {
-                    stat.errmsg = print_err;
-
-                    std::cerr
-                        << std::endl
-                        << "the PRINT benchmark for \"" << impl->name() << "\" finished with error: "
-                        << print_err << std::endl
-                    ;
-
-                    return false;
+        if ( opts.alloc_profile && opts.alloc_sites && alloc_tracker::available() ) {
+            os << "Library|Phase|Bytes|Allocations|Call stack" << std::endl;
+            os << "---|---|---|---|---" << std::endl;
+            for ( const auto &[impl, stat]: results ) {
+                const std::pair<const char *, const std::vector<alloc_site> *> phases[] = {
+                     {"parse", &stat.parse_alloc_sites}
+                    ,{"print", &stat.print_alloc_sites}
+                };
+                for ( const auto &[phase, sites]: phases ) {
+                    for ( const auto &it: *sites ) {
+                        os
+                            << stat.name
+                            << "|" << phase
+                            << "|" << it.bytes
+                            << "|" << it.allocations
+                            << "|`" << it.stack << "`"
+                            << std::endl
+                        ;
+                    }
                 }
             }
+            os << std::endl;
+        }
 
-            malloc_stat_vars print_stat = MALLOC_STAT_GET_STAT(get_alloc_stat);
-            auto print_time = impl->duration(print_start);
-
-            std::cout << "done" << std::endl;
-            ///////////////////////////////////////////////////////// free
-            std::cout << "    free... " << std::flush;
+        if ( !failures.empty() ) {
+            os << "Library|Failed with" << std::endl;
+            os << "---|---" << std::endl;
+            for ( const auto &[name, emsg]: failures ) {
+                os << name << "|" << emsg << std::endl;
+            }
+            os << std::endl;
+        }
 
-            auto free_start = impl->start_time();
-            MALLOC_STAT_RESET_STAT(get_alloc_stat);
+        // the machine-readable copies are written next to the report
+        const auto json_fname = fs::path{report_fname}.replace_extension(".json").string();
+        const auto csv_fname = fs::path{report_fname}.replace_extension(".csv").string();
+        auto env = make_environment(suite, input_fname, fsize, json_values, opts);
+        for ( const auto &res: {write_results_json(json_fname, env, results), write_results_csv(csv_fname, results)} ) {
+            if ( !res.first ) {
+                std::cerr << "  WARN: " << res.second << std::endl;
+            }
+        }
 
-            impl->finish();
+        // the reports are overwritten by each run, the history is not
+        if ( !opts.history_fname.empty() ) {
+            const auto trend_fname = fs::path{report_fname}.replace_filename(suite + "-trend.html").string();
+            auto res = append_history(opts.history_fname, env, results);
+            if ( res.first ) {
+                res = write_trend_report(
+                     opts.history_fname
+                    ,trend_fname
+                    ,environment_value(env, "machine")
+                    ,suite
+                );
+            }
+            if ( !res.first ) {
+                std::cerr << "  WARN: " << res.second << std::endl;
+            }
+        }
 
-            malloc_stat_vars free_stat = MALLOC_STAT_GET_STAT(get_alloc_stat);
-            auto free_time = impl->duration(free_start);
-
-            std::cout << "done" << std::endl;
-            ///////////////////////////////////////////////////////// check
-            std::cout << "    comparing... " << std::flush;
-            auto check_start = impl->start_time();
-
-            //auto check_res = impl->check(input_io.get(), output_io.get(), json_flags);
-
-            auto check_time = impl->duration(check_start);
-
-            std::cout << "done, took " << check_time/1000.0 << " s" << std::endl;
-            ///////////////////////////////////////////////////////// end
-
-            stat.time_to_prepare = prepare_time;
-            stat.prepare_allocated = prepare_stat.allocated;
-            stat.prepare_allocations = prepare_stat.allocations;
-            stat.prepare_deallocations = prepare_stat.deallocations;
-            stat.time_to_parse = parse_time;
-            stat.parse_allocated = parse_stat.allocated;
-            stat.parse_allocations = parse_stat.allocations;
-            stat.parse_deallocations = parse_stat.deallocations;
-            stat.time_to_print = print_time;
-            stat.print_allocated = print_stat.allocated;
-            stat.print_allocations = print_stat.allocations;
-            stat.print_deallocations = print_stat.deallocations;
-            stat.time_to_free = free_time;
-
-            stat.free_deallocated = free_stat.deallocated;
-            stat.free_deallocations = free_stat.deallocations;
-
-            auto summ_of_allocs = prepare_stat.allocations + parse_stat.allocations + print_stat.allocations + free_stat.allocations;
-            auto summ_of_allocated = prepare_stat.allocated + parse_stat.allocated + print_stat.allocated + free_stat.allocated;
-            auto summ_of_deallocs = prepare_stat.deallocations + parse_stat.deallocations + print_stat.deallocations + free_stat.deallocations;
-            auto summ_of_deallocated = prepare_stat.deallocated + parse_stat.deallocated + print_stat.deallocated + free_stat.deallocated;
-            stat.free_leaked_bytes = summ_of_allocated - summ_of_deallocated;
-            stat.free_leaked_allocations = summ_of_allocs - summ_of_deallocs;
+        if ( !opts.baseline_fname.empty() ) {
+            std::vector<regression> regressions;
+            auto [ok, emsg] = compare_with_baseline(&regressions, opts.baseline_fname, results, opts.thresholds);
+            if ( !ok ) {
+                std::cerr << emsg << std::endl;
 
-            std::cout << stat;
+                return false;
+            }
 
-            auto allowed_leaks = impl->allowed_leaks();
-            if ( allowed_leaks.first != stat.free_leaked_bytes || allowed_leaks.second != stat.free_leaked_allocations ) {
-                std::cerr
-                    << "  WARN: leaked memory suspicion ("
-                    << stat.free_leaked_bytes << " bytes, "
-                    << stat.free_leaked_allocations << " in blocks)"
-                << std::endl;
+            os << "Regressions against " << opts.baseline_fname
+               << " (time +" << (opts.thresholds.time * 100.0)
+               << "%, allocations +" << (opts.thresholds.allocations * 100.0)
+               << "%, peak +" << (opts.thresholds.peak * 100.0) << "%)" << std::endl;
+            os << std::endl;
+            if ( regressions.empty() ) {
+                os << "none" << std::endl;
             } else {
-                if ( stat.free_leaked_bytes ) {
-                    std::cerr << " (as expected!)" << std::endl;
-                } else {
-                    std::cerr << std::endl;
-                }
+                os << "Library|Phase|Metric|Baseline|Current|Change %" << std::endl;
+                os << "---|---|---|---|---|---" << std::endl;
             }
-
-            // when we are faced with JSON test mismatch - there is no reason
-            // for inclusion that test results into the report...
-            if ( 0 /*!check_res.first*/ ) {
+            for ( const auto &it: regressions ) {
+                const auto change = it.baseline ? (it.current / it.baseline - 1.0) * 100.0 : 100.0;
+                os
+                    << it.library
+                    << "|" << it.phase
+                    << "|" << it.metric
+                    << "|" << it.baseline
+                    << "|" << it.current
+                    << "|" << change
+                    << std::endl
+                ;
                 std::cerr
-                    << "  WARN: the comparison test for the SOURCE and GENERATED JSON was failed with error: " << "check_res.second" << "\"\n"
-                    << "  the results of that test will not be included into the report!"
-                << std::endl;
-            } else {
-    //            os << "Library|Time to read s|Time to write s|Memory footprint on read MB|Memory footprint on write MB|Allocations on read|Allocations on write|Remarks" << std::endl;
-    //            os << "---|---|---|---|---|---|---|---" << std::endl;
-
-    //            os
-    //                << "[" << impl->name() << "](" << impl->url() << ")"
-    //                << "|" << stat.time_to_parse
-    //                << "|" << stat.time_to_print
-    //                << "|" << stat.parse_memory_used
-    //                << "|" << stat.print_memory_used
-    //                << "|" << stat.parse_allocations
-    //                << "|" << stat.print_allocations
-    //                << "|" << impl->notes()
-    //                << std::endl
-    //            ;
+                    << "  REGRESSION: " << it.library << " " << it.phase << " " << it.metric
+                    << ": " << it.baseline << " -> " << it.current << " (+" << change << "%)"
+                    << std::endl
+                ;
             }
+            os << std::endl;
+
+            *regressed = !regressions.empty();
         }
-        os << std::endl;
+
+        return failures.empty();
     } catch (const std::exception &e) {
         std::cout << "benchmarks error: " << e.what() << std::endl;
 
         return false;
     }
-
-    return true;
 }
 
 /*************************************************************************************************/
@@ -455,13 +1957,14 @@ void usage(const char *argv0) {
     p = (p ? p+1: argv0);
 
     std::cout
-        << p << " [ints, floats, strings, mixed, smallfile]" << std::endl
+        << p << " [ints, floats, strings, mixed, smallfile, ndjson]" << std::endl
         << "  ints      - use integers for generate test data" << std::endl
         << "  floats    - use floats for generate test data" << std::endl
         << "  strings   - use strings for generate test data" << std::endl
         << "  keywords  - use JSON keywords for generate test data" << std::endl
         << "  mixed     - use mixed mode for generate test data" << std::endl
-        << "  smallfile - test using small test data" << std::endl
+        << "  smallfile - per-document latency of data/input/small_file/*.json" << std::endl
+        << "  ndjson    - NDJSON records benchmark" << std::endl
         << "  despaced  - generated test data will not contain any spaces" << std::endl
         << "--- can be used together ---" << std::endl
         << std::endl
@@ -479,6 +1982,13 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
+    // the calibration takes ~60ms, so do it before any measurement
+    std::cout
+        << "timer: " << clock_source_name(phase_timer::source())
+        << ", TSC: " << phase_timer::tsc_hz() << " Hz"
+        << ", overhead: " << phase_timer::overhead_ns() << " ns" << std::endl
+    ;
+
     struct kwords: cmdargs::kwords_group {
         CMDARGS_OPTION_ADD(mode, e_data_generator_mode::k_e, "test mode selector"
             ,validator_([](const char *str, std::size_t len){
@@ -503,7 +2013,9 @@ int main(int argc, char **argv) {
                                 ? e_data_generator_mode::keywords
                                 : s == s_data_generator_mode[4]
                                     ? e_data_generator_mode::mixed
-                                    : e_data_generator_mode::smallfile
+                                    : s == s_data_generator_mode[7]
+                                        ? e_data_generator_mode::ndjson
+                                        : e_data_generator_mode::smallfile
                 ;
 
                 return true;
@@ -515,6 +2027,105 @@ int main(int argc, char **argv) {
         CMDARGS_OPTION_ADD(num_strings, std::size_t, "number of strings in generated JSON", optional);
         CMDARGS_OPTION_ADD(num_keywords, std::size_t, "number of keywords in generated JSON", optional);
         CMDARGS_OPTION_ADD(num_repeats, std::size_t, "number of strings in generated JSON", optional);
+        CMDARGS_OPTION_ADD(warmups, std::size_t, "number of untimed warmup trials for each library", optional);
+        CMDARGS_OPTION_ADD(iterations, std::size_t, "number of measured trials for each library", optional);
+        CMDARGS_OPTION_ADD(bootstrap, std::size_t, "number of bootstrap resamples for the confidence intervals", optional);
+        CMDARGS_OPTION_ADD(adaptive, bool, "run the trials until the CI of parse and print medians is narrow enough", optional);
+        CMDARGS_OPTION_ADD(target_ci, double, "adaptive mode: relative CI half-width to reach, in percents", optional);
+        CMDARGS_OPTION_ADD(time_budget, std::size_t, "adaptive mode: wall-clock budget for each library, in seconds", optional);
+        CMDARGS_OPTION_ADD(max_iterations, std::size_t, "adaptive mode: maximum number of measured trials", optional);
+        CMDARGS_OPTION_ADD(cpu, std::size_t, "pin the benchmark thread to this CPU", optional);
+        CMDARGS_OPTION_ADD(fifo, std::size_t, "use SCHED_FIFO with this priority for the benchmark thread", optional);
+        CMDARGS_OPTION_ADD(isolate, isolation_mode, "run in child processes: none, library, trial", optional
+            ,validator_([](const char *str, std::size_t len){
+                for ( const auto &it: s_isolation_mode ) {
+                    if ( std::strlen(it) == len && std::strncmp(it, str, len) == 0 ) {
+                        return true;
+                    }
+                }
+
+                return false;
+            })
+            ,converter_([](void *dstptr, const char *str, std::size_t len){
+                auto &dst = *static_cast<isolation_mode *>(dstptr);
+                std::string s{str, len};
+                dst = s == s_isolation_mode[1]
+                    ? isolation_mode::library
+                    : s == s_isolation_mode[2]
+                        ? isolation_mode::trial
+                        : isolation_mode::none
+                ;
+
+                return true;
+            })
+        );
+
+        CMDARGS_OPTION_ADD(alloc_profile, bool, "collect the allocation size classes and lifetimes in an extra untimed trial", optional);
+        CMDARGS_OPTION_ADD(alloc_sites, std::size_t, "number of the top allocating call stacks to report with alloc_profile, 0 to disable", optional);
+        CMDARGS_OPTION_ADD(alloc_timeline, std::size_t, "with alloc_profile, sample the live bytes each N allocations into CSV", optional);
+        CMDARGS_OPTION_ADD(baseline, std::string, "compare with the JSON results of a previous run, exit with failure on regressions", optional);
+        CMDARGS_OPTION_ADD(threshold_time, double, "baseline: allowed growth of the median time, in percents", optional);
+        CMDARGS_OPTION_ADD(threshold_allocs, double, "baseline: allowed growth of the number of allocations, in percents", optional);
+        CMDARGS_OPTION_ADD(threshold_peak, double, "baseline: allowed growth of the peak live bytes, in percents", optional);
+        CMDARGS_OPTION_ADD(threads, std::size_t, "run the scaling benchmark on 1..N threads instead of the single-threaded one", optional);
+        CMDARGS_OPTION_ADD(placement, std::string, "scaling: the thread placement policy: compact, spread, smt, bandwidth, all", optional);
+        CMDARGS_OPTION_ADD(shared_input, bool, "scaling: all the threads parse the same mapping of the input", optional);
+        CMDARGS_OPTION_ADD(small_file_iterations, std::size_t, "smallfile mode: number of measured trials for each document and library", optional);
+        CMDARGS_OPTION_ADD(profile, std::string, "run the sampling profiler for this library variant, e.g. yyjson-insitu, or \"all\", and write the folded stacks", optional);
+        CMDARGS_OPTION_ADD(profile_phase, trial_phase, "the phase to profile: prepare, parse, print, free, traverse", optional
+            ,validator_([](const char *str, std::size_t len){
+                for ( auto i = 0u; i < static_cast<std::size_t>(trial_phase::count_); ++i ) {
+                    const auto *it = trial_phase_name(static_cast<trial_phase>(i));
+                    if ( std::strlen(it) == len && std::strncmp(it, str, len) == 0 ) {
+                        return true;
+                    }
+                }
+
+                return false;
+            })
+            ,converter_([](void *dstptr, const char *str, std::size_t len){
+                auto &dst = *static_cast<trial_phase *>(dstptr);
+                std::string s{str, len};
+                for ( auto i = 0u; i < static_cast<std::size_t>(trial_phase::count_); ++i ) {
+                    if ( s == trial_phase_name(static_cast<trial_phase>(i)) ) {
+                        dst = static_cast<trial_phase>(i);
+                    }
+                }
+
+                return true;
+            })
+        );
+        CMDARGS_OPTION_ADD(profile_freq, std::size_t, "the sampling profiler frequency, in Hz", optional);
+        CMDARGS_OPTION_ADD(allocator, std::string, "comma-separated allocators: system, arena, pool, freelist, or all", optional);
+        CMDARGS_OPTION_ADD(reuse, bool, "also run the libraries which can keep the parser/document across the trials in that mode", optional);
+        CMDARGS_OPTION_ADD(sax, bool, "also measure the SAX parse, without building the DOM, of the libraries supporting it", optional);
+        CMDARGS_OPTION_ADD(chunks, std::string, "comma-separated chunk sizes, e.g. 1K,4K,64K,1M, to measure the incremental parse of the libraries supporting it", optional);
+        CMDARGS_OPTION_ADD(traverse, bool, "also measure the reads of the parsed document: dfs, lookup, arrays, random, by the libraries supporting it", optional);
+        CMDARGS_OPTION_ADD(io_matrix, bool, "run each library with each pair of the input/output devices it supports: string_buffer, std_strstreams, std_fstreams, stdio_streams, fd_streams, mmap_streams", optional);
+        CMDARGS_OPTION_ADD(history, std::string, "append the results to this JSONL file and write reports/<mode>-trend.html, empty to disable", optional);
+        CMDARGS_OPTION_ADD(cache, cache_mode, "the state of the caches before parse: as_is, cold, hot", optional
+            ,validator_([](const char *str, std::size_t len){
+                for ( const auto &it: s_cache_mode ) {
+                    if ( std::strlen(it) == len && std::strncmp(it, str, len) == 0 ) {
+                        return true;
+                    }
+                }
+
+                return false;
+            })
+            ,converter_([](void *dstptr, const char *str, std::size_t len){
+                auto &dst = *static_cast<cache_mode *>(dstptr);
+                std::string s{str, len};
+                dst = s == s_cache_mode[1]
+                    ? cache_mode::cold
+                    : s == s_cache_mode[2]
+                        ? cache_mode::hot
+                        : cache_mode::as_is
+                ;
+
+                return true;
+            })
+        );
 
         CMDARGS_OPTION_ADD_HELP();
         CMDARGS_OPTION_ADD_VERSION();
@@ -544,7 +2155,45 @@ int main(int argc, char **argv) {
     const auto num_floats  = args.get(kwords.num_floats, 5000);
     const auto num_strings = args.get(kwords.num_strings, 5000);
     const auto num_keywords= args.get(kwords.num_keywords, 5000);
-    const auto num_repeats = args.get(kwords.num_repeats, 5000);
+    // the number of the records in the ndjson mode
+    const auto num_repeats = args.get(kwords.num_repeats, mode == e_data_generator_mode::ndjson ? 1000000 : 5000);
+    const auto warmups     = args.get(kwords.warmups, 1);
+    const auto iterations  = args.get(kwords.iterations, 5);
+    const auto bootstrap   = args.get(kwords.bootstrap, 1000);
+    const auto adaptive    = args.get(kwords.adaptive, false);
+    const auto target_ci   = args.get(kwords.target_ci, 1.0);
+    const auto time_budget = args.get(kwords.time_budget, 60);
+    const auto max_iterations = args.get(kwords.max_iterations, 100000);
+    const int  cpu         = args.is_set(kwords.cpu) ? static_cast<int>(args.get(kwords.cpu)) : -1;
+    const int  fifo        = static_cast<int>(args.get(kwords.fifo, 0));
+    const auto isolate     = args.get(kwords.isolate, isolation_mode::none);
+    const auto cache       = args.get(kwords.cache, cache_mode::as_is);
+    const auto alloc_prof  = args.get(kwords.alloc_profile, false);
+#ifdef ALLOC_BACKTRACES
+    const auto alloc_sites = args.get(kwords.alloc_sites, 10);
+#else
+    // the call stacks are useless without the frame pointers
+    const auto alloc_sites = args.get(kwords.alloc_sites, 0);
+#endif // ALLOC_BACKTRACES
+    const auto alloc_timeline = args.get(kwords.alloc_timeline, 0);
+    const auto baseline    = args.get(kwords.baseline, std::string{});
+    const auto threshold_time = args.get(kwords.threshold_time, 5.0);
+    const auto threshold_allocs = args.get(kwords.threshold_allocs, 1.0);
+    const auto threshold_peak = args.get(kwords.threshold_peak, 5.0);
+    const auto history     = args.get(kwords.history, std::string{"data/output/history.jsonl"});
+    const auto threads     = args.get(kwords.threads, std::size_t{0});
+    const auto placement   = args.get(kwords.placement, std::string{"all"});
+    const auto shared_input = args.get(kwords.shared_input, false);
+    const auto small_file_iterations = args.get(kwords.small_file_iterations, std::size_t{20000});
+    const auto profile     = args.get(kwords.profile, std::string{});
+    const auto profile_phase = args.get(kwords.profile_phase, trial_phase::parse);
+    const auto profile_freq = args.get(kwords.profile_freq, std::size_t{4000});
+    const auto allocator   = args.get(kwords.allocator, std::string{"system"});
+    const auto reuse       = args.get(kwords.reuse, false);
+    const auto io_matrix   = args.get(kwords.io_matrix, false);
+    const auto sax         = args.get(kwords.sax, false);
+    const auto chunks      = args.get(kwords.chunks, std::string{});
+    const auto traverse    = args.get(kwords.traverse, false);
     std::cout
         << kwords.mode.name() << ": " << mode << ", "
         << kwords.despaced.name() << ": " << despaced << ", "
@@ -552,9 +2201,229 @@ int main(int argc, char **argv) {
         << kwords.num_floats.name() << ": " << num_floats << ", "
         << kwords.num_strings.name() << ": " << num_strings << ", "
         << kwords.num_keywords.name() << ": " << num_keywords << ", "
-        << kwords.num_repeats.name() << ": " << num_repeats << std::endl
+        << kwords.num_repeats.name() << ": " << num_repeats << ", "
+        << kwords.warmups.name() << ": " << warmups << ", "
+        << kwords.iterations.name() << ": " << iterations << ", "
+        << kwords.bootstrap.name() << ": " << bootstrap << ", "
+        << kwords.adaptive.name() << ": " << adaptive << ", "
+        << kwords.target_ci.name() << ": " << target_ci << ", "
+        << kwords.time_budget.name() << ": " << time_budget << ", "
+        << kwords.max_iterations.name() << ": " << max_iterations << ", "
+        << kwords.cpu.name() << ": " << cpu << ", "
+        << kwords.fifo.name() << ": " << fifo << ", "
+        << kwords.isolate.name() << ": " << isolate << ", "
+        << kwords.cache.name() << ": " << cache << ", "
+        << kwords.alloc_profile.name() << ": " << alloc_prof << ", "
+        << kwords.alloc_sites.name() << ": " << alloc_sites << ", "
+        << kwords.alloc_timeline.name() << ": " << alloc_timeline << ", "
+        << kwords.baseline.name() << ": " << baseline << ", "
+        << kwords.threshold_time.name() << ": " << threshold_time << ", "
+        << kwords.threshold_allocs.name() << ": " << threshold_allocs << ", "
+        << kwords.threshold_peak.name() << ": " << threshold_peak << ", "
+        << kwords.history.name() << ": " << history << ", "
+        << kwords.threads.name() << ": " << threads << ", "
+        << kwords.placement.name() << ": " << placement << ", "
+        << kwords.shared_input.name() << ": " << shared_input << ", "
+        << kwords.small_file_iterations.name() << ": " << small_file_iterations << ", "
+        << kwords.profile.name() << ": " << profile << ", "
+        << kwords.profile_phase.name() << ": " << trial_phase_name(profile_phase) << ", "
+        << kwords.profile_freq.name() << ": " << profile_freq << ", "
+        << kwords.allocator.name() << ": " << allocator << ", "
+        << kwords.reuse.name() << ": " << reuse << ", "
+        << kwords.io_matrix.name() << ": " << io_matrix << ", "
+        << kwords.sax.name() << ": " << sax << ", "
+        << kwords.chunks.name() << ": " << chunks << ", "
+        << kwords.traverse.name() << ": " << traverse << std::endl
     ;
 
+    // should be done before the test file generation, so the page cache
+    // of the test file belongs to the NUMA node of the pinned CPU
+    if ( cpu >= 0 ) {
+        auto emsg = pin_to_cpu(cpu);
+        if ( !emsg.empty() ) {
+            std::cout << "can't pin to cpu " << cpu << ": " << emsg << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+    if ( fifo ) {
+        auto emsg = set_fifo_scheduling(fifo);
+        if ( !emsg.empty() ) {
+            std::cout << "can't set SCHED_FIFO/" << fifo << ": " << emsg << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+    if ( iterations == 0 ) {
+        std::cout << "cmdline error: " << kwords.iterations.name() << " can't be zero" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    std::vector<placement_policy> policies;
+    for ( auto i = 0u; i < static_cast<std::size_t>(placement_policy::count_); ++i ) {
+        const auto policy = static_cast<placement_policy>(i);
+        if ( placement == "all" || placement == placement_policy_name(policy) ) {
+            policies.push_back(policy);
+        }
+    }
+    if ( policies.empty() ) {
+        std::cout << "cmdline error: " << kwords.placement.name() << " must be compact, spread, smt, bandwidth or all" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    std::vector<allocator_kind> allocators;
+    for ( std::size_t pos = 0; pos <= allocator.size(); ) {
+        const auto end = std::min(allocator.find(',', pos), allocator.size());
+        const auto item = allocator.substr(pos, end - pos);
+        pos = end + 1;
+        bool known = false;
+        for ( auto i = 0u; i < static_cast<std::size_t>(allocator_kind::count_); ++i ) {
+            const auto kind = static_cast<allocator_kind>(i);
+            if ( item != "all" && item != allocator_kind_name(kind) ) {
+                continue;
+            }
+            known = true;
+            if ( std::find(allocators.begin(), allocators.end(), kind) == allocators.end() ) {
+                allocators.push_back(kind);
+            }
+        }
+        if ( !known ) {
+            allocators.clear();
+            break;
+        }
+    }
+    if ( allocators.empty() ) {
+        std::cout << "cmdline error: " << kwords.allocator.name() << " must be the comma-separated system, arena, pool, freelist or all" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    std::vector<std::size_t> chunk_sizes;
+    for ( std::size_t pos = 0; pos < chunks.size(); ) {
+        const auto end = std::min(chunks.find(',', pos), chunks.size());
+        const auto item = chunks.substr(pos, end - pos);
+        pos = end + 1;
+        std::size_t digits = 0;
+        while ( digits < item.size() && std::isdigit(static_cast<unsigned char>(item[digits])) ) {
+            ++digits;
+        }
+        const auto suffix = item.substr(digits);
+        std::size_t size = digits ? std::stoull(item.substr(0, digits)) : 0;
+        if ( suffix == "K" || suffix == "k" ) {
+            size *= 1024;
+        } else if ( suffix == "M" || suffix == "m" ) {
+            size *= 1024 * 1024;
+        } else if ( !suffix.empty() ) {
+            size = 0;
+        }
+        if ( !size ) {
+            std::cout << "cmdline error: " << kwords.chunks.name() << " must be the comma-separated sizes with the optional K or M suffix" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+        chunk_sizes.push_back(size);
+    }
+    // the threads inherit the affinity of the main thread
+    if ( threads && cpu >= 0 ) {
+        std::cout << "cmdline error: " << kwords.threads.name() << " can't be used with " << kwords.cpu.name() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    // the small files and the scaling benchmarks run on the system allocator only
+    const bool system_allocator = allocators.size() == 1 && allocators.front() == allocator_kind::system;
+    if ( !system_allocator && (threads || mode == e_data_generator_mode::smallfile) ) {
+        std::cout << "cmdline error: " << kwords.allocator.name() << " can't be used with "
+            << (threads ? kwords.threads.name() : "the smallfile mode") << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    // the ndjson mode writes the markdown report only, runs on the system allocator
+    // in the current process, and measures the records parse only
+    if ( mode == e_data_generator_mode::ndjson ) {
+        const char *unsupported = args.is_set(kwords.baseline) ? kwords.baseline.name()
+            : args.is_set(kwords.history) ? kwords.history.name()
+            : args.is_set(kwords.threads) ? kwords.threads.name()
+            : args.is_set(kwords.allocator) ? kwords.allocator.name()
+            : args.is_set(kwords.isolate) ? kwords.isolate.name()
+            : args.is_set(kwords.alloc_profile) ? kwords.alloc_profile.name()
+            : args.is_set(kwords.profile) ? kwords.profile.name()
+            : args.is_set(kwords.reuse) ? kwords.reuse.name()
+            : args.is_set(kwords.io_matrix) ? kwords.io_matrix.name()
+            : args.is_set(kwords.sax) ? kwords.sax.name()
+            : args.is_set(kwords.chunks) ? kwords.chunks.name()
+            : args.is_set(kwords.traverse) ? kwords.traverse.name()
+            : nullptr
+        ;
+        if ( unsupported ) {
+            std::cout << "cmdline error: " << unsupported << " can't be used in the ndjson mode" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::size_t json_flags = 0;
+    json_flags = despaced ? (json_flags | e_json_flags::despaced) : 0u;
+
+    benchmark_options opts;
+    opts.json_flags = json_flags;
+    // the hot mode requires at least one untimed parse
+    opts.warmups = cache == cache_mode::hot ? std::max<std::size_t>(warmups, 1) : warmups;
+    opts.iterations = iterations;
+    opts.bootstrap_resamples = bootstrap;
+    opts.adaptive = adaptive;
+    opts.target_ci = target_ci / 100.0;
+    opts.time_budget_ns = time_budget * 1000000000ull;
+    opts.max_iterations = std::max<std::size_t>(max_iterations, iterations);
+    opts.cpu = cpu;
+    opts.fifo_priority = fifo;
+    opts.isolation = isolate;
+    opts.cache = cache;
+    opts.alloc_profile = alloc_prof;
+    opts.alloc_sites = alloc_sites;
+    opts.alloc_timeline = alloc_timeline;
+    opts.baseline_fname = baseline;
+    opts.thresholds.time = threshold_time / 100.0;
+    opts.thresholds.allocations = threshold_allocs / 100.0;
+    opts.thresholds.peak = threshold_peak / 100.0;
+    opts.history_fname = history;
+    opts.profile_library = profile;
+    opts.profile_phase = profile_phase;
+    opts.profile_frequency = profile_freq;
+    opts.allocators = allocators;
+    opts.reuse = reuse;
+    opts.io_matrix = io_matrix;
+    opts.sax = sax;
+    opts.chunk_sizes = chunk_sizes;
+    opts.traverse = traverse;
+    opts.input_io = io_type::mmap_streams;
+    opts.output_io = io_type::string_buffer;
+
+    // the documents are not generated, their size is what matters
+    if ( mode == e_data_generator_mode::smallfile ) {
+        static const std::string input_dir = "data/input/small_file";
+        std::vector<std::string> input_fnames;
+        for ( const auto &it: fs::directory_iterator{input_dir} ) {
+            if ( it.path().extension() == ".json" ) {
+                input_fnames.push_back(it.path().string());
+            }
+        }
+        std::sort(input_fnames.begin(), input_fnames.end());
+        if ( input_fnames.empty() ) {
+            std::cout << "no JSON files in " << input_dir << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        // the inputs may contain the spaces whatever 'despaced' says
+        opts.json_flags = 0;
+        auto benchmarks = create_benchmarks();
+        std::cout << "small files test started, " << small_file_iterations << " times each..." << std::endl;
+
+        return benchmark_small_files(benchmarks, "reports/smallfile.md", input_fnames, small_file_iterations, opts)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE
+        ;
+    }
+
     static const std::string test_file_fname = "data/output/testdata.json";
     std::string output_dir = fs::path{test_file_fname}.parent_path();
     if ( !fs::exists(output_dir) ) {
@@ -597,53 +2466,47 @@ int main(int argc, char **argv) {
             report_fname = "reports/mixed.md";
             break;
         }
-        case e_data_generator_mode::smallfile: {
-            report_fname = "reports/smallfile.md";
+        case e_data_generator_mode::ndjson: {
+            report_fname = "reports/ndjson.md";
             break;
         }
         default: assert("wrong mode" == nullptr);
     }
 
-    std::cout << "ints test started..." << std::endl;
-    std::size_t json_flags = 0;
-    json_flags = despaced ? (json_flags | e_json_flags::despaced) : 0u;
-
     auto benchmarks = create_benchmarks();
+    // the whole file is not a single JSON, so the DOM benchmarks don't apply
+    if ( mode == e_data_generator_mode::ndjson ) {
+        std::cout << "ndjson test started..." << std::endl;
+
+        return benchmark_records(benchmarks, report_fname, test_file_fname, opts)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE
+        ;
+    }
+    if ( threads ) {
+        const auto scaling_fname = fs::path{report_fname}.replace_filename(
+            fs::path{report_fname}.stem().string() + "-scaling.md").string();
+        std::cout << "scaling test started, up to " << threads << " threads..." << std::endl;
+
+        return benchmark_scaling(benchmarks, scaling_fname, test_file_fname, threads, policies, shared_input, opts)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE
+        ;
+    }
+
+    std::cout << "ints test started..." << std::endl;
+    bool regressed = false;
     if ( !benchmark(
          benchmarks
         ,report_fname
         ,test_file_fname
         ,output_dir
-        ,json_flags)
+        ,opts
+        ,&regressed)
     ) {
         return EXIT_FAILURE;
     }
 
-#ifdef SMALL_FILE_TEST_ENABLED
-    if ( small_file ) {
-        const std::string input_fname = "data/input/small_file/small_file_text_array.json";
-        const std::string output_dir = "data/output/small_file";
-        const std::string output_fname_prefix = "small_file_text_array_";
-        size_t number_times = 50000;
-
-        if ( !fs::exists(output_dir) ) {
-            fs::create_directories(output_dir);
-        }
-
-        std::cout << "small file test started, " << number_times << " times..." << std::endl;
-
-        if ( !benchmarks_small_file(
-                  number_times
-                 ,implementations
-                 ,input_fname
-                 ,output_dir
-                 ,output_fname_prefix)
-        ) {
-            return EXIT_FAILURE;
-        }
-    }
-#endif // SMALL_FILE_TEST_ENABLED
-
 #if 0
     std::vector<result_code_info> result_code_infos;
     result_code_infos.push_back(result_code_info{result_code::expected_result,"Expected result","#008000"});
@@ -660,7 +2523,7 @@ int main(int argc, char **argv) {
     reporter.run_tests();
 #endif // 0
 
-    return EXIT_SUCCESS;
+    return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*************************************************************************************************/
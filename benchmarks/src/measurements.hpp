@@ -10,11 +10,19 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <iosfwd>
 #include <filesystem>
 
 #include <malloc-stat/api.h>
 
+#include "stats.hpp"
+#include "hdr_histogram.hpp"
+#include "perf_counters.hpp"
+#include "os_tools.hpp"
+#include "alloc_tracker.hpp"
+
 namespace json_benchmarks {
 
 namespace fs = std::filesystem;
@@ -67,30 +75,154 @@ inline std::string human_size(std::uint64_t bytes) {
 
 /*************************************************************************************************/
 
+inline std::string human_time(std::uint64_t ns) {
+    static const char *suffix[] = {"ns", "us", "ms", "s"};
+    static const int length = sizeof(suffix) / sizeof(suffix[0]);
+
+    int i = 0;
+    double dblTime = ns;
+    for ( ; dblTime >= 1000.0 && i < length-1; ++i ) {
+        dblTime /= 1000.0;
+    }
+
+    char output[200];
+    std::snprintf(output, sizeof(output), "%.03lf %s", dblTime, suffix[i]);
+
+    return output;
+}
+
+/*************************************************************************************************/
+
+// the incremental parse of the input fed in the fixed-size chunks
+struct chunked_parse_result {
+    std::size_t chunk_size;
+    std::vector<std::uint64_t> samples; // of the whole input, per measured trial
+    sample_stats stats;
+    // the latency of one parse_chunk() call over all the measured trials, in nanoseconds.
+    // the percentiles are taken from the histogram merged over all the processes
+    hdr_histogram chunk_hist;
+    std::uint64_t chunk_p50;
+    std::uint64_t chunk_p99;
+    std::uint64_t chunk_max;
+    size_t allocated;   // of the last trial
+    size_t allocations;
+
+    void compute_percentiles() {
+        chunk_p50 = chunk_hist.value_at_percentile(50.0);
+        chunk_p99 = chunk_hist.value_at_percentile(99.0);
+        chunk_max = chunk_hist.max();
+    }
+
+    // MB/s of the input, by the median of the whole input times
+    double throughput(std::size_t input_size) const {
+        return stats.median ? (input_size / 1000000.0) / (stats.median / 1e9) : 0.0;
+    }
+};
+
+/*************************************************************************************************/
+
+// the reads of the parsed document with one of the access patterns
+struct traverse_result {
+    std::uint32_t pattern; // traverse_pattern
+    std::vector<std::uint64_t> samples; // per measured trial
+    sample_stats stats;
+    size_t allocated;   // of the last trial
+    size_t allocations;
+    // of the last trial, the same for all of them
+    size_t values;
+    size_t strings;
+    double numbers;
+
+    double ns_per_value() const {
+        return values ? static_cast<double>(stats.median) / values : 0.0;
+    }
+};
+
+/*************************************************************************************************/
+
 struct measurements {
     std::string name;
     std::string errmsg;
+    // all the times are in nanoseconds.
+    // the time_to_* are the medians of the samples of the measured trials.
     size_t prepare_allocated;
     size_t prepare_allocations;
     size_t prepare_deallocations;
-    size_t time_to_prepare;
+    std::uint64_t time_to_prepare;
     size_t parse_allocated;
     size_t parse_allocations;
     size_t parse_deallocations;
-    size_t time_to_parse;
+    std::uint64_t time_to_parse;
     size_t print_allocated;
     size_t print_allocations;
     size_t print_deallocations;
-    size_t time_to_print;
+    std::uint64_t time_to_print;
     size_t free_deallocated;
     size_t free_deallocations;
     size_t free_leaked_bytes;
     size_t free_leaked_allocations;
-    size_t time_to_free;
+    std::uint64_t time_to_free;
+    bool leaks_as_expected; // the leaks are equal to benchmarks::allowed_leaks()
+    bool converged;         // the adaptive mode reached the target CI
+    // the first trial, including the setup the reuse mode skips in the next ones
+    std::uint64_t first_trial_time; // prepare + parse
+    size_t first_trial_allocated;
+    size_t first_trial_allocations;
+    // the SAX parse trials, when the library supports it
+    std::uint64_t time_to_sax_parse;
+    size_t sax_parse_allocated;
+    size_t sax_parse_allocations;
+    size_t sax_events;   // of the last trial, the same for all of them
+    double sax_numbers;
+    // for each chunk size, when the library supports the chunked parse
+    std::vector<chunked_parse_result> chunked;
+    // for each traverse pattern, when the library supports the traverse
+    std::vector<traverse_result> traversed;
+
+    // the number of untimed warmup trials, and the per-trial samples of the measured ones
+    std::size_t warmups;
+    std::vector<std::uint64_t> prepare_samples;
+    std::vector<std::uint64_t> parse_samples;
+    std::vector<std::uint64_t> print_samples;
+    std::vector<std::uint64_t> free_samples;
+    std::vector<std::uint64_t> sax_parse_samples;
+    sample_stats prepare_stats;
+    sample_stats parse_stats;
+    sample_stats print_stats;
+    sample_stats free_stats;
+    sample_stats sax_parse_stats;
+    // the hardware counters, averaged over the measured trials
+    perf_counters prepare_counters;
+    perf_counters parse_counters;
+    perf_counters print_counters;
+    perf_counters free_counters;
+    // the page faults, CPU times, context switches and RSS, averaged over the measured trials
+    resource_usage prepare_usage;
+    resource_usage parse_usage;
+    resource_usage print_usage;
+    resource_usage free_usage;
+    // collected in the extra untimed trial, when enabled
+    alloc_profile prepare_alloc_profile;
+    alloc_profile parse_alloc_profile;
+    alloc_profile print_alloc_profile;
+    alloc_profile free_alloc_profile;
+    // the top call stacks by the allocated bytes, when the backtraces are enabled
+    std::vector<alloc_site> parse_alloc_sites;
+    std::vector<alloc_site> print_alloc_sites;
+    // the live bytes during the profiled trial, when enabled
+    std::vector<alloc_timeline_point> alloc_timeline;
+    // used to normalize the times
+    std::size_t input_size;   // in bytes
+    std::size_t output_size;  // in bytes
+    std::size_t json_values;  // number of the JSON values in the input
 
     measurements()
         :name{}
         ,errmsg{}
+        ,prepare_allocated{}
+        ,prepare_allocations{}
+        ,prepare_deallocations{}
+        ,time_to_prepare{}
         ,parse_allocated{}
         ,parse_allocations{}
         ,parse_deallocations{}
@@ -104,16 +236,192 @@ struct measurements {
         ,free_leaked_bytes{}
         ,free_leaked_allocations{}
         ,time_to_free{}
+        ,leaks_as_expected{true}
+        ,converged{}
+        ,first_trial_time{}
+        ,first_trial_allocated{}
+        ,first_trial_allocations{}
+        ,time_to_sax_parse{}
+        ,sax_parse_allocated{}
+        ,sax_parse_allocations{}
+        ,sax_events{}
+        ,sax_numbers{}
+        ,chunked{}
+        ,traversed{}
+        ,warmups{}
+        ,prepare_samples{}
+        ,parse_samples{}
+        ,print_samples{}
+        ,free_samples{}
+        ,sax_parse_samples{}
+        ,prepare_stats{}
+        ,parse_stats{}
+        ,print_stats{}
+        ,free_stats{}
+        ,sax_parse_stats{}
+        ,prepare_counters{}
+        ,parse_counters{}
+        ,print_counters{}
+        ,free_counters{}
+        ,prepare_usage{}
+        ,parse_usage{}
+        ,print_usage{}
+        ,free_usage{}
+        ,prepare_alloc_profile{}
+        ,parse_alloc_profile{}
+        ,print_alloc_profile{}
+        ,free_alloc_profile{}
+        ,parse_alloc_sites{}
+        ,print_alloc_sites{}
+        ,alloc_timeline{}
+        ,input_size{}
+        ,output_size{}
+        ,json_values{}
     {}
 
+    // appends the trials measured by another process
+    void merge_trials(const measurements &r) {
+        prepare_allocated = r.prepare_allocated;
+        prepare_allocations = r.prepare_allocations;
+        prepare_deallocations = r.prepare_deallocations;
+        parse_allocated = r.parse_allocated;
+        parse_allocations = r.parse_allocations;
+        parse_deallocations = r.parse_deallocations;
+        print_allocated = r.print_allocated;
+        print_allocations = r.print_allocations;
+        print_deallocations = r.print_deallocations;
+        free_deallocated = r.free_deallocated;
+        free_deallocations = r.free_deallocations;
+        free_leaked_bytes = r.free_leaked_bytes;
+        free_leaked_allocations = r.free_leaked_allocations;
+        leaks_as_expected = leaks_as_expected && r.leaks_as_expected;
+        // each child process has its own first trial, the first child's one is kept
+        if ( !first_trial_time ) {
+            first_trial_time = r.first_trial_time;
+            first_trial_allocated = r.first_trial_allocated;
+            first_trial_allocations = r.first_trial_allocations;
+        }
+        prepare_samples.insert(prepare_samples.end(), r.prepare_samples.begin(), r.prepare_samples.end());
+        parse_samples.insert(parse_samples.end(), r.parse_samples.begin(), r.parse_samples.end());
+        print_samples.insert(print_samples.end(), r.print_samples.begin(), r.print_samples.end());
+        free_samples.insert(free_samples.end(), r.free_samples.begin(), r.free_samples.end());
+        sax_parse_samples.insert(sax_parse_samples.end(), r.sax_parse_samples.begin(), r.sax_parse_samples.end());
+        sax_parse_allocated = r.sax_parse_allocated;
+        sax_parse_allocations = r.sax_parse_allocations;
+        sax_events = r.sax_events;
+        sax_numbers = r.sax_numbers;
+        // the samples are appended and the chunk latency histograms are merged
+        if ( chunked.empty() ) {
+            chunked = r.chunked;
+        } else {
+            for ( std::size_t i = 0; i < chunked.size() && i < r.chunked.size(); ++i ) {
+                auto &l = chunked[i];
+                const auto &rc = r.chunked[i];
+                l.samples.insert(l.samples.end(), rc.samples.begin(), rc.samples.end());
+                l.chunk_hist += rc.chunk_hist;
+                l.allocated = rc.allocated;
+                l.allocations = rc.allocations;
+            }
+        }
+        if ( traversed.empty() ) {
+            traversed = r.traversed;
+        } else {
+            for ( std::size_t i = 0; i < traversed.size() && i < r.traversed.size(); ++i ) {
+                auto &l = traversed[i];
+                const auto &rt = r.traversed[i];
+                l.samples.insert(l.samples.end(), rt.samples.begin(), rt.samples.end());
+                l.allocated = rt.allocated;
+                l.allocations = rt.allocations;
+            }
+        }
+        prepare_counters += r.prepare_counters;
+        parse_counters += r.parse_counters;
+        print_counters += r.print_counters;
+        free_counters += r.free_counters;
+        prepare_usage += r.prepare_usage;
+        parse_usage += r.parse_usage;
+        print_usage += r.print_usage;
+        free_usage += r.free_usage;
+        // only one of the child processes collects the profiles
+        if ( r.parse_alloc_profile.collected ) {
+            prepare_alloc_profile = r.prepare_alloc_profile;
+            parse_alloc_profile = r.parse_alloc_profile;
+            print_alloc_profile = r.print_alloc_profile;
+            free_alloc_profile = r.free_alloc_profile;
+            parse_alloc_sites = r.parse_alloc_sites;
+            print_alloc_sites = r.print_alloc_sites;
+            alloc_timeline = r.alloc_timeline;
+        }
+        output_size = r.output_size;
+    }
+
+    // MB/s of the input consumed by parse()
+    double parse_throughput() const {
+        return time_to_parse ? (input_size / 1000000.0) / (time_to_parse / 1e9) : 0.0;
+    }
+    // MB/s of the output produced by print()
+    double print_throughput() const {
+        return time_to_print ? (output_size / 1000000.0) / (time_to_print / 1e9) : 0.0;
+    }
+    // the hardware cycles when available, otherwise the TSC reference cycles, 0 without both
+    double parse_cycles_per_byte(std::uint64_t tsc_hz) const {
+        return cycles_per_byte(parse_counters, time_to_parse, input_size, tsc_hz);
+    }
+    double print_cycles_per_byte(std::uint64_t tsc_hz) const {
+        return cycles_per_byte(print_counters, time_to_print, output_size, tsc_hz);
+    }
+    double parse_ns_per_value() const {
+        return json_values ? static_cast<double>(time_to_parse) / json_values : 0.0;
+    }
+    double print_ns_per_value() const {
+        return json_values ? static_cast<double>(time_to_print) / json_values : 0.0;
+    }
+    double sax_parse_throughput() const {
+        return time_to_sax_parse ? (input_size / 1000000.0) / (time_to_sax_parse / 1e9) : 0.0;
+    }
+
+    static double cycles_per_byte(const perf_counters &c, std::uint64_t ns, std::size_t bytes, std::uint64_t tsc_hz) {
+        if ( !bytes ) {
+            return 0.0;
+        }
+        if ( c.is_valid(perf_event::cycles) ) {
+            return static_cast<double>(c.get(perf_event::cycles)) / bytes;
+        }
+
+        return (ns / 1e9) * tsc_hz / bytes;
+    }
+
     friend std::ostream& operator<< (std::ostream &os, const measurements &m) {
         os
             << "    errmsg: " << (m.errmsg.empty() ? "nope" : m.errmsg.c_str()) << std::endl
-            << "    prepare time: " << m.time_to_prepare/1000.0 << ", allocated : " << human_size(m.prepare_allocated) << ", allocs: " << m.prepare_allocations << ", deallocs: " << m.prepare_deallocations << std::endl
-            << "    parse   time: " << m.time_to_parse/1000.0 << ", allocated : " << human_size(m.parse_allocated) << ", allocs: " << m.parse_allocations << ", deallocs: " << m.parse_deallocations << std::endl
-            << "    print   time: " << m.time_to_print/1000.0 << ", allocated : " << human_size(m.print_allocated) << ", allocs: " << m.print_allocations << ", deallocs: " << m.print_deallocations << std::endl
-            << "    free    time: " << m.time_to_free/1000.0 << ", deallocated: " << human_size(m.free_deallocated) << ", deallocs: " << m.free_deallocations << std::endl
-            << "    leaked bytes: " << m.free_leaked_bytes << ", leaked allocs: " << m.free_leaked_allocations << std::flush;
+            << "    prepare time: " << human_time(m.time_to_prepare) << ", allocated : " << human_size(m.prepare_allocated) << ", allocs: " << m.prepare_allocations << ", deallocs: " << m.prepare_deallocations << std::endl
+            << "    parse   time: " << human_time(m.time_to_parse) << ", allocated : " << human_size(m.parse_allocated) << ", allocs: " << m.parse_allocations << ", deallocs: " << m.parse_deallocations << std::endl
+            << "    print   time: " << human_time(m.time_to_print) << ", allocated : " << human_size(m.print_allocated) << ", allocs: " << m.print_allocations << ", deallocs: " << m.print_deallocations << std::endl
+            << "    free    time: " << human_time(m.time_to_free) << ", deallocated: " << human_size(m.free_deallocated) << ", deallocs: " << m.free_deallocations << std::endl
+            << "    leaked bytes: " << m.free_leaked_bytes << ", leaked allocs: " << m.free_leaked_allocations << std::endl
+            << "    warmups: " << m.warmups << ", trials: " << m.parse_samples.size() << std::endl
+            << "    first   time: " << human_time(m.first_trial_time) << ", allocated : " << human_size(m.first_trial_allocated) << ", allocs: " << m.first_trial_allocations << std::endl
+            << "    sax     time: " << human_time(m.time_to_sax_parse) << ", allocated : " << human_size(m.sax_parse_allocated) << ", allocs: " << m.sax_parse_allocations << ", events: " << m.sax_events << ", trials: " << m.sax_parse_samples.size() << std::endl
+            << "    prepare stat: " << m.prepare_stats << std::endl
+            << "    parse   stat: " << m.parse_stats << std::endl
+            << "    print   stat: " << m.print_stats << std::endl
+            << "    free    stat: " << m.free_stats << std::endl
+            << "    prepare counters: " << m.prepare_counters << std::endl
+            << "    parse   counters: " << m.parse_counters << std::endl
+            << "    print   counters: " << m.print_counters << std::endl
+            << "    free    counters: " << m.free_counters << std::endl
+            << "    prepare usage: " << m.prepare_usage << std::endl
+            << "    parse   usage: " << m.parse_usage << std::endl
+            << "    print   usage: " << m.print_usage << std::endl
+            << "    free    usage: " << m.free_usage << std::endl
+            << "    prepare allocs profile: " << m.prepare_alloc_profile << std::endl
+            << "    parse   allocs profile: " << m.parse_alloc_profile << std::endl
+            << "    print   allocs profile: " << m.print_alloc_profile << std::endl
+            << "    free    allocs profile: " << m.free_alloc_profile << std::endl
+            << "    parse   top alloc site: " << (m.parse_alloc_sites.empty() ? std::string{"n/a"} : m.parse_alloc_sites.front().stack) << std::endl
+            << "    print   top alloc site: " << (m.print_alloc_sites.empty() ? std::string{"n/a"} : m.print_alloc_sites.front().stack) << std::endl
+            << "    parse   MB/s: " << m.parse_throughput() << ", ns/value: " << m.parse_ns_per_value() << std::endl
+            << "    print   MB/s: " << m.print_throughput() << ", ns/value: " << m.print_ns_per_value() << std::flush;
         ;
 
         return os;
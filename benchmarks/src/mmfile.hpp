@@ -18,7 +18,11 @@ namespace json_benchmarks {
 struct mmsource {
     mmsource(const char *fname)
         :m_fd{::open(fname, O_RDONLY)}
-    { assert(open()); }
+    {
+        const bool ok = open();
+        assert(ok);
+        (void)ok;
+    }
 
     ~mmsource() {
         if ( m_fd == -1 ) {
@@ -44,12 +48,34 @@ struct mmsource {
         return ::posix_madvise(m_addr, m_size, POSIX_MADV_SEQUENTIAL) == 0;
     }
 
+    // unmaps the pages and evicts the file from the page cache,
+    // so the next access will read the file from the storage
+    bool drop_page_cache() {
+        bool ok = ::madvise(m_addr, m_size, MADV_DONTNEED) == 0;
+
+        return ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED) == 0 && ok;
+    }
+
+    // maps all the pages in advance, so the next access will not cause a page fault
+    void prefault() {
+        ::madvise(m_addr, m_size, MADV_WILLNEED);
+
+        const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const volatile char *ptr = static_cast<const char*>(m_addr);
+        char sum = 0;
+        for ( size_t i = 0; i < m_size; i += page_size ) {
+            sum += ptr[i];
+        }
+        (void)sum;
+    }
+
     const char* begin() const { return static_cast<const char*>(m_addr); }
     const char* end()   const { return static_cast<const char*>(m_addr) + m_size; }
 
     const char* data() const { return static_cast<const char*>(m_addr); }
     char*       data()       { return static_cast<char*>(m_addr); }
     size_t      size() const { return m_size; }
+    int         fd()   const { return m_fd; }
 
 private:
     int m_fd;
@@ -64,7 +90,11 @@ struct mmsink {
         :ofname{fname}
         ,m_fd{-1}
         ,m_size{max_size}
-    { assert(open()); }
+    {
+        const bool ok = open();
+        assert(ok);
+        (void)ok;
+    }
 
     ~mmsink() {
         if ( m_fd == -1 ) {
@@ -78,6 +108,7 @@ struct mmsink {
     bool resize(size_t new_size) {
         bool ok = ::ftruncate(m_fd, new_size) == 0;
         assert(ok);
+        (void)ok;
 
         void *p = ::mremap(m_addr, m_size, new_size, MREMAP_MAYMOVE);
         assert(p != MAP_FAILED);
@@ -94,7 +125,9 @@ struct mmsink {
             return false;
         }
 
-        assert(::ftruncate(m_fd, m_size) == 0);
+        const auto rc = ::ftruncate(m_fd, m_size);
+        assert(rc == 0);
+        (void)rc;
 
         m_addr = ::mmap(nullptr, m_size, PROT_READ|PROT_WRITE, MAP_SHARED, m_fd, 0);
         assert(m_addr != MAP_FAILED);
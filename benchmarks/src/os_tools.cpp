@@ -6,6 +6,13 @@
 // See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
 
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <ostream>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
 #include <cassert>
 
 #ifdef WIN32
@@ -16,6 +23,8 @@
 #   include <sys/stat.h>
 #   include <unistd.h>
 #   include <sys/resource.h>
+#   include <fcntl.h>
+#   include <sched.h>
 #else
 #   error "unknown OS"
 #endif
@@ -25,6 +34,41 @@
 
 namespace json_benchmarks {
 
+std::size_t get_process_memory() {
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if ( !::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)) ) {
+        return 0;
+    }
+
+    return pmc.WorkingSetSize;
+#elif defined(__linux__)
+    // the format is "size resident shared text lib data dt" in pages.
+    // the stdio/iostreams are not used to not allocate the memory
+    int fd = ::open("/proc/self/statm", O_RDONLY);
+    if ( fd == -1 ) {
+        return 0;
+    }
+
+    char buf[128];
+    auto rd = ::read(fd, buf, sizeof(buf) - 1);
+    ::close(fd);
+    if ( rd <= 0 ) {
+        return 0;
+    }
+    buf[rd] = 0;
+
+    unsigned long size = 0, resident = 0;
+    if ( std::sscanf(buf, "%lu %lu", &size, &resident) != 2 ) {
+        return 0;
+    }
+
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#else
+#   error "unknown OS"
+#endif
+}
+
 std::string get_os_type() {
 #ifdef WIN32
     return "Windows";
@@ -230,4 +274,331 @@ std::size_t file_size(int fd) {
     return st.st_size;
 }
 
+/*************************************************************************************************/
+
+std::string pin_to_cpu(int cpu) {
+#ifdef WIN32
+    return "UNIMPLEMENTED";
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if ( ::sched_setaffinity(0, sizeof(set), &set) != 0 ) {
+        return std::strerror(errno);
+    }
+
+    return std::string{};
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::string set_fifo_scheduling(int priority) {
+#ifdef WIN32
+    return "UNIMPLEMENTED";
+#elif defined(__linux__)
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    if ( ::sched_setscheduler(0, SCHED_FIFO, &param) != 0 ) {
+        return std::strerror(errno);
+    }
+
+    return std::string{};
+#else
+#   error "unknown OS"
+#endif
+}
+
+int get_current_cpu() {
+#ifdef WIN32
+    return -1;
+#elif defined(__linux__)
+    return ::sched_getcpu();
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::string get_cpufreq_governor(int cpu) {
+#ifdef WIN32
+    return "UNIMPLEMENTED";
+#elif defined(__linux__)
+    std::ifstream is{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor"};
+    if ( !is ) {
+        return "UNKNOWN";
+    }
+
+    std::string governor;
+    std::getline(is, governor);
+
+    return governor.empty() ? "UNKNOWN" : governor;
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::string get_turbo_state() {
+#ifdef WIN32
+    return "UNIMPLEMENTED";
+#elif defined(__linux__)
+    // intel_pstate reports the inverted value
+    std::ifstream is{"/sys/devices/system/cpu/intel_pstate/no_turbo"};
+    if ( is ) {
+        std::string v;
+        std::getline(is, v);
+
+        return v == "1" ? "disabled" : "enabled";
+    }
+
+    std::ifstream is2{"/sys/devices/system/cpu/cpufreq/boost"};
+    if ( is2 ) {
+        std::string v;
+        std::getline(is2, v);
+
+        return v == "1" ? "enabled" : "disabled";
+    }
+
+    return "UNKNOWN";
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::vector<int> get_smt_siblings(int cpu) {
+    std::vector<int> res;
+#ifdef WIN32
+    return res;
+#elif defined(__linux__)
+    std::ifstream is{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"};
+    if ( !is ) {
+        return res;
+    }
+
+    // the format is like "0,4" or "0-1"
+    std::string list;
+    std::getline(is, list);
+    std::istringstream ss{list};
+    for ( std::string item; std::getline(ss, item, ','); ) {
+        auto pos = item.find('-');
+        int from = std::stoi(item.substr(0, pos));
+        int to = pos == std::string::npos ? from : std::stoi(item.substr(pos + 1));
+        for ( int i = from; i <= to; ++i ) {
+            if ( i != cpu ) {
+                res.push_back(i);
+            }
+        }
+    }
+
+    return res;
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::vector<cpu_location> get_cpu_topology() {
+    std::vector<cpu_location> res;
+#ifdef WIN32
+    const auto count = static_cast<int>(std::thread::hardware_concurrency());
+    for ( int i = 0; i < count; ++i ) {
+        res.push_back({i, i, 0});
+    }
+
+    return res;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if ( ::sched_getaffinity(0, sizeof(set), &set) != 0 ) {
+        return res;
+    }
+
+    auto read_id = [](int cpu, const char *name, int def) {
+        std::ifstream is{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name};
+        int id = def;
+
+        return (is >> id) ? id : def;
+    };
+    for ( int i = 0; i < CPU_SETSIZE; ++i ) {
+        if ( CPU_ISSET(i, &set) ) {
+            res.push_back({i, read_id(i, "core_id", i), read_id(i, "physical_package_id", 0)});
+        }
+    }
+
+    return res;
+#else
+#   error "unknown OS"
+#endif
+}
+
+std::size_t get_llc_size() {
+#ifdef WIN32
+    return 0;
+#elif defined(__linux__)
+    std::size_t res = 0;
+    int max_level = 0;
+    for ( int i = 0; ; ++i ) {
+        const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i);
+        std::ifstream level_is{dir + "/level"};
+        std::ifstream size_is{dir + "/size"};
+        if ( !level_is || !size_is ) {
+            break;
+        }
+
+        int level = 0;
+        level_is >> level;
+        // the format is like "32768K"
+        std::size_t size = 0;
+        std::string suffix;
+        size_is >> size >> suffix;
+        if ( suffix == "K" ) {
+            size *= 1024;
+        } else if ( suffix == "M" ) {
+            size *= 1024 * 1024;
+        }
+
+        if ( level >= max_level ) {
+            max_level = level;
+            res = size;
+        }
+    }
+
+    return res;
+#else
+#   error "unknown OS"
+#endif
+}
+
+void flush_cpu_caches() {
+    // when the size is unknown, 64MB is enough for most of the desktop/server CPUs
+    static const std::size_t size = get_llc_size() ? get_llc_size() * 2 : 64u * 1024u * 1024u;
+    static std::vector<char> buffer(size);
+
+    // the writes evicts the dirty lines too
+    volatile char *ptr = buffer.data();
+    for ( std::size_t i = 0; i < size; i += 64 ) {
+        ptr[i] = static_cast<char>(ptr[i] + 1);
+    }
+}
+
+double get_cpu_load(int cpu, unsigned sample_ms) {
+#ifdef WIN32
+    return -1.0;
+#elif defined(__linux__)
+    // returns {busy, total} jiffies of the 'cpu'
+    auto read_stat = [cpu]() -> std::pair<std::uint64_t, std::uint64_t> {
+        std::ifstream is{"/proc/stat"};
+        const std::string prefix = "cpu" + std::to_string(cpu) + " ";
+        std::string line;
+        while ( std::getline(is, line) ) {
+            if ( line.compare(0, prefix.size(), prefix) != 0 ) {
+                continue;
+            }
+
+            std::istringstream ss{line.substr(prefix.size())};
+            std::uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+            ss >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+            auto busy = user + nice + system + irq + softirq + steal;
+
+            return {busy, busy + idle + iowait};
+        }
+
+        return {0, 0};
+    };
+
+    auto first = read_stat();
+    std::this_thread::sleep_for(std::chrono::milliseconds(sample_ms));
+    auto second = read_stat();
+    if ( second.second <= first.second ) {
+        return -1.0;
+    }
+
+    return 100.0 * (second.first - first.first) / (second.second - first.second);
+#else
+#   error "unknown OS"
+#endif
+}
+
+/*************************************************************************************************/
+
+resource_usage& resource_usage::operator+= (const resource_usage &r) {
+    minor_faults += r.minor_faults;
+    major_faults += r.major_faults;
+    user_time_ns += r.user_time_ns;
+    sys_time_ns += r.sys_time_ns;
+    voluntary_switches += r.voluntary_switches;
+    involuntary_switches += r.involuntary_switches;
+    rss_before += r.rss_before;
+    rss_after += r.rss_after;
+
+    return *this;
+}
+
+resource_usage& resource_usage::operator/= (std::size_t n) {
+    if ( n ) {
+        minor_faults /= n;
+        major_faults /= n;
+        user_time_ns /= n;
+        sys_time_ns /= n;
+        voluntary_switches /= n;
+        involuntary_switches /= n;
+        rss_before /= n;
+        rss_after /= n;
+    }
+
+    return *this;
+}
+
+std::ostream& operator<< (std::ostream &os, const resource_usage &u) {
+    return os
+        << "minor faults: " << u.minor_faults
+        << ", major faults: " << u.major_faults
+        << ", user: " << (u.user_time_ns / 1e6) << " ms"
+        << ", sys: " << (u.sys_time_ns / 1e6) << " ms"
+        << ", vcs: " << u.voluntary_switches
+        << ", ivcs: " << u.involuntary_switches
+        << ", RSS: " << (u.rss_before / 1024) << " KB -> " << (u.rss_after / 1024) << " KB"
+    ;
+}
+
+resource_usage get_resource_usage() {
+    resource_usage res;
+#ifdef WIN32
+    // UNIMPLEMENTED
+#elif defined(__linux__)
+    struct rusage ru;
+    if ( ::getrusage(RUSAGE_THREAD, &ru) == 0 ) {
+        auto ns = [](const struct timeval &tv) {
+            return static_cast<std::uint64_t>(tv.tv_sec) * 1000000000u + static_cast<std::uint64_t>(tv.tv_usec) * 1000u;
+        };
+        res.minor_faults = ru.ru_minflt;
+        res.major_faults = ru.ru_majflt;
+        res.user_time_ns = ns(ru.ru_utime);
+        res.sys_time_ns = ns(ru.ru_stime);
+        res.voluntary_switches = ru.ru_nvcsw;
+        res.involuntary_switches = ru.ru_nivcsw;
+    }
+#else
+#   error "unknown OS"
+#endif
+    res.rss_before = res.rss_after = get_process_memory();
+
+    return res;
+}
+
+resource_usage resource_usage_delta(const resource_usage &start, const resource_usage &stop) {
+    resource_usage res;
+    res.minor_faults = stop.minor_faults - start.minor_faults;
+    res.major_faults = stop.major_faults - start.major_faults;
+    res.user_time_ns = stop.user_time_ns - start.user_time_ns;
+    res.sys_time_ns = stop.sys_time_ns - start.sys_time_ns;
+    res.voluntary_switches = stop.voluntary_switches - start.voluntary_switches;
+    res.involuntary_switches = stop.involuntary_switches - start.involuntary_switches;
+    res.rss_before = start.rss_after;
+    res.rss_after = stop.rss_after;
+
+    return res;
+}
+
+/*************************************************************************************************/
+
 } // ns json_benchmarks
@@ -9,10 +9,13 @@
 #define JSON_BENCHMARKS_MEASURER_HPP
 
 #include <string>
+#include <vector>
 #include <cstdint>
+#include <iosfwd>
 
 namespace json_benchmarks {
 
+// the resident set size of the process in bytes
 std::size_t get_process_memory();
 std::string get_os_type();
 std::string get_os();
@@ -25,6 +28,63 @@ std::string get_ram();
 std::size_t file_size(const char *fname);
 std::size_t file_size(int fd);
 
+// the scheduling isolation helpers.
+// those which change the state return the error message, empty on success.
+std::string pin_to_cpu(int cpu);
+std::string set_fifo_scheduling(int priority);
+int get_current_cpu();
+std::string get_cpufreq_governor(int cpu);
+std::string get_turbo_state();
+std::vector<int> get_smt_siblings(int cpu); // not including the 'cpu' itself
+
+// the location of the logical CPU
+struct cpu_location {
+    int cpu;
+    int core;    // unique within the package only
+    int package;
+};
+// the CPUs the process is allowed to run on, ordered by the CPU number
+std::vector<cpu_location> get_cpu_topology();
+// the size of the last level cache in bytes, zero if unknown
+std::size_t get_llc_size();
+// evicts the data from the CPU caches by sweeping a buffer two times larger than LLC
+void flush_cpu_caches();
+
+// the busy percentage of the 'cpu' during the 'sample_ms' period, negative on error
+double get_cpu_load(int cpu, unsigned sample_ms);
+
+// the OS accounting of the calling thread.
+// the snapshot has rss_before == rss_after, the delta has the RSS at the start and at the stop.
+struct resource_usage {
+    std::uint64_t minor_faults;
+    std::uint64_t major_faults;
+    std::uint64_t user_time_ns;
+    std::uint64_t sys_time_ns;
+    std::uint64_t voluntary_switches;
+    std::uint64_t involuntary_switches;
+    std::uint64_t rss_before; // in bytes
+    std::uint64_t rss_after;  // in bytes
+
+    resource_usage()
+        :minor_faults{}
+        ,major_faults{}
+        ,user_time_ns{}
+        ,sys_time_ns{}
+        ,voluntary_switches{}
+        ,involuntary_switches{}
+        ,rss_before{}
+        ,rss_after{}
+    {}
+
+    resource_usage& operator+= (const resource_usage &r);
+    resource_usage& operator/= (std::size_t n);
+
+    friend std::ostream& operator<< (std::ostream &os, const resource_usage &u);
+};
+
+resource_usage get_resource_usage();
+resource_usage resource_usage_delta(const resource_usage &start, const resource_usage &stop);
+
 } // ns json_benchmarks
 
 #endif
@@ -0,0 +1,263 @@
+
+#include "perf_counters.hpp"
+
+#include <fstream>
+#include <ostream>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#   include <unistd.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+const char* perf_event_name(perf_event ev) {
+    switch ( ev ) {
+        case perf_event::cycles: return "cycles";
+        case perf_event::instructions: return "instructions";
+        case perf_event::branch_misses: return "branch-misses";
+        case perf_event::l1d_misses: return "L1D-misses";
+        case perf_event::llc_misses: return "LLC-misses";
+        case perf_event::dtlb_misses: return "dTLB-misses";
+        case perf_event::count_: break;
+    }
+
+    return "UNKNOWN";
+}
+
+/*************************************************************************************************/
+
+bool perf_counters::any_valid() const {
+    for ( auto it: valid ) {
+        if ( it ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+double perf_counters::ipc() const {
+    if ( !is_valid(perf_event::cycles) || !is_valid(perf_event::instructions) ) {
+        return 0.0;
+    }
+    auto cycles = get(perf_event::cycles);
+
+    return cycles ? static_cast<double>(get(perf_event::instructions)) / cycles : 0.0;
+}
+
+perf_counters& perf_counters::operator+= (const perf_counters &r) {
+    for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+        valid[i] = valid[i] || r.valid[i];
+        values[i] += r.values[i];
+    }
+
+    return *this;
+}
+
+perf_counters& perf_counters::operator/= (std::size_t n) {
+    if ( n ) {
+        for ( auto &it: values ) {
+            it /= n;
+        }
+    }
+
+    return *this;
+}
+
+std::ostream& operator<< (std::ostream &os, const perf_counters &c) {
+    if ( !c.any_valid() ) {
+        return os << "n/a";
+    }
+
+    for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+        os << (i ? ", " : "") << perf_event_name(static_cast<perf_event>(i)) << ": ";
+        if ( c.valid[i] ) {
+            os << c.values[i];
+        } else {
+            os << "n/a";
+        }
+    }
+
+    return os << ", IPC: " << c.ipc();
+}
+
+/*************************************************************************************************/
+
+#ifdef __linux__
+
+namespace {
+
+int perf_event_open(perf_event_attr *attr, int group_fd) {
+    return static_cast<int>(::syscall(__NR_perf_event_open, attr, 0, -1, group_fd, 0));
+}
+
+void init_attr(perf_event_attr *attr, perf_event ev) {
+    std::memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->disabled = 1;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+        | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    auto cache = [](std::uint64_t id, std::uint64_t op, std::uint64_t result) {
+        return id | (op << 8) | (result << 16);
+    };
+
+    switch ( ev ) {
+        case perf_event::cycles:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case perf_event::instructions:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case perf_event::branch_misses:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case perf_event::l1d_misses:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case perf_event::llc_misses:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case perf_event::dtlb_misses:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case perf_event::count_: break;
+    }
+}
+
+std::string paranoid_level() {
+    std::ifstream is{"/proc/sys/kernel/perf_event_paranoid"};
+    std::string level;
+    if ( !is || !std::getline(is, level) ) {
+        return "UNKNOWN";
+    }
+
+    return level;
+}
+
+} // anon ns
+
+perf_group::perf_group()
+    :m_fds{}
+    ,m_ids{}
+    ,m_error{}
+{
+    for ( auto &it: m_fds ) {
+        it = -1;
+    }
+
+    for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+        perf_event_attr attr;
+        init_attr(&attr, static_cast<perf_event>(i));
+
+        int fd = perf_event_open(&attr, m_fds[0]);
+        if ( fd == -1 ) {
+            if ( i == 0 ) {
+                m_error = "perf_event_open(): ";
+                m_error += std::strerror(errno);
+                m_error += ", perf_event_paranoid=";
+                m_error += paranoid_level();
+
+                return;
+            }
+
+            // the rest of the events are optional
+            continue;
+        }
+
+        m_fds[i] = fd;
+        ::ioctl(fd, PERF_EVENT_IOC_ID, &m_ids[i]);
+    }
+}
+
+perf_group::~perf_group() {
+    for ( auto it: m_fds ) {
+        if ( it != -1 ) {
+            ::close(it);
+        }
+    }
+}
+
+bool perf_group::available() const { return m_fds[0] != -1; }
+
+const std::string& perf_group::error() const { return m_error; }
+
+void perf_group::start() {
+    if ( !available() ) {
+        return;
+    }
+
+    ::ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+perf_counters perf_group::stop() {
+    perf_counters res;
+    if ( !available() ) {
+        return res;
+    }
+
+    ::ioctl(m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // nr, time_enabled, time_running, {value, id}[nr]
+    std::uint64_t buf[3 + 2 * static_cast<std::size_t>(perf_event::count_)];
+    if ( ::read(m_fds[0], buf, sizeof(buf)) <= 0 ) {
+        return res;
+    }
+
+    const auto nr = buf[0];
+    const auto enabled = buf[1];
+    const auto running = buf[2];
+    // the group was multiplexed with other events, so the values are scaled
+    const double scale = running ? static_cast<double>(enabled) / running : 0.0;
+    for ( auto j = 0u; j < nr; ++j ) {
+        const auto value = buf[3 + j * 2];
+        const auto id = buf[3 + j * 2 + 1];
+        for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+            if ( m_fds[i] != -1 && m_ids[i] == id ) {
+                res.valid[i] = running != 0;
+                res.values[i] = static_cast<std::uint64_t>(value * scale);
+            }
+        }
+    }
+
+    return res;
+}
+
+#else // !__linux__
+
+perf_group::perf_group()
+    :m_fds{}
+    ,m_ids{}
+    ,m_error{"perf_event_open() is available on Linux only"}
+{
+    for ( auto &it: m_fds ) {
+        it = -1;
+    }
+}
+perf_group::~perf_group() {}
+bool perf_group::available() const { return false; }
+const std::string& perf_group::error() const { return m_error; }
+void perf_group::start() {}
+perf_counters perf_group::stop() { return perf_counters{}; }
+
+#endif // __linux__
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,74 @@
+#ifndef JSON_BENCHMARKS_PERF_COUNTERS_HPP
+#define JSON_BENCHMARKS_PERF_COUNTERS_HPP
+
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+enum class perf_event {
+     cycles
+    ,instructions
+    ,branch_misses
+    ,l1d_misses
+    ,llc_misses
+    ,dtlb_misses
+    ,count_ // must be the last
+};
+
+const char* perf_event_name(perf_event ev);
+
+struct perf_counters {
+    // the counter which is not supported by the CPU/kernel is marked as invalid
+    bool valid[static_cast<std::size_t>(perf_event::count_)];
+    std::uint64_t values[static_cast<std::size_t>(perf_event::count_)];
+
+    perf_counters()
+        :valid{}
+        ,values{}
+    {}
+
+    bool is_valid(perf_event ev) const { return valid[static_cast<std::size_t>(ev)]; }
+    std::uint64_t get(perf_event ev) const { return values[static_cast<std::size_t>(ev)]; }
+    bool any_valid() const;
+
+    // instructions per cycle, zero when any of them is unavailable
+    double ipc() const;
+
+    perf_counters& operator+= (const perf_counters &r);
+    perf_counters& operator/= (std::size_t n);
+
+    friend std::ostream& operator<< (std::ostream &os, const perf_counters &c);
+};
+
+// the group of hardware counters for the calling thread.
+// the user-space only events are requested, so it works with perf_event_paranoid <= 2.
+// when the group can't be opened all the counters are reported as invalid.
+struct perf_group {
+    perf_group();
+    ~perf_group();
+
+    perf_group(const perf_group &) = delete;
+    perf_group& operator= (const perf_group &) = delete;
+
+    bool available() const;
+    // the reason why the counters are not available
+    const std::string& error() const;
+
+    void start();
+    perf_counters stop();
+
+private:
+    int m_fds[static_cast<std::size_t>(perf_event::count_)];
+    std::uint64_t m_ids[static_cast<std::size_t>(perf_event::count_)];
+    std::string m_error;
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_PERF_COUNTERS_HPP
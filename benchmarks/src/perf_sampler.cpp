@@ -0,0 +1,346 @@
+
+#include "perf_sampler.hpp"
+
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#   include <unistd.h>
+#   include <dlfcn.h>
+#   include <elf.h>
+#   include <cxxabi.h>
+#   include <sys/mman.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+#ifdef __linux__
+
+namespace {
+
+// 2^N data pages plus the header page
+constexpr std::size_t ring_data_pages = 1024;
+
+int perf_event_open(perf_event_attr *attr) {
+    return static_cast<int>(::syscall(__NR_perf_event_open, attr, 0, -1, -1, 0));
+}
+
+void init_attr(perf_event_attr *attr, std::uint32_t type, std::uint64_t config, std::size_t frequency) {
+    std::memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = type;
+    attr->config = config;
+    attr->freq = 1;
+    attr->sample_freq = frequency;
+    attr->sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
+    attr->disabled = 1;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->exclude_callchain_kernel = 1;
+}
+
+std::string demangle(const char *name) {
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    std::string res = status == 0 && demangled ? demangled : name;
+    std::free(demangled);
+
+    return res;
+}
+
+// the addresses of the position-independent modules are passed to addr2line as the offsets
+bool is_relocatable(const std::string &path) {
+    std::ifstream is{path, std::ios::binary};
+    unsigned char ident[EI_NIDENT + sizeof(Elf64_Half)];
+    if ( !is.read(reinterpret_cast<char *>(ident), sizeof(ident)) ) {
+        return true;
+    }
+    Elf64_Half type;
+    std::memcpy(&type, ident + EI_NIDENT, sizeof(type));
+
+    return type != ET_EXEC;
+}
+
+struct module_frames {
+    bool relocatable;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> addrs; // address, address for addr2line
+};
+
+// symbolizes the frames of one module, 'names' is pre-filled with the fallback names
+void run_addr2line(const std::string &path, const module_frames &frames, std::map<std::uint64_t, std::string> *names) {
+    static constexpr std::size_t batch = 256;
+    for ( auto i = 0u; i < frames.addrs.size(); i += batch ) {
+        std::string cmd = "addr2line -C -f -e '" + path + "'";
+        const auto end = std::min(frames.addrs.size(), i + batch);
+        for ( auto j = i; j < end; ++j ) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), " 0x%llx", static_cast<unsigned long long>(frames.addrs[j].second));
+            cmd += buf;
+        }
+        cmd += " 2>/dev/null";
+
+        FILE *pipe = ::popen(cmd.c_str(), "r");
+        if ( !pipe ) {
+            return;
+        }
+        // two lines per address: the function and the file:line
+        char func[4096], line[4096];
+        for ( auto j = i; j < end && std::fgets(func, sizeof(func), pipe) && std::fgets(line, sizeof(line), pipe); ++j ) {
+            func[std::strcspn(func, "\n")] = 0;
+            if ( std::strcmp(func, "??") != 0 ) {
+                (*names)[frames.addrs[j].first] = func;
+            }
+        }
+        ::pclose(pipe);
+    }
+}
+
+// the function names of the unique addresses
+std::map<std::uint64_t, std::string> symbolize(const std::set<std::uint64_t> &addrs) {
+    Dl_info self;
+    ::dladdr(reinterpret_cast<void *>(&symbolize), &self);
+    // the name of the executable is argv[0], which is not always a path
+    char exe[4096] = {};
+    if ( ::readlink("/proc/self/exe", exe, sizeof(exe) - 1) <= 0 ) {
+        std::strcpy(exe, self.dli_fname);
+    }
+
+    std::map<std::uint64_t, std::string> names;
+    std::map<std::string, module_frames> modules;
+    for ( auto addr: addrs ) {
+        Dl_info info;
+        if ( !::dladdr(reinterpret_cast<void *>(addr), &info) || !info.dli_fname ) {
+            names[addr] = "[unknown]";
+            continue;
+        }
+
+        const std::string path = info.dli_fbase == self.dli_fbase ? exe : info.dli_fname;
+        const auto offset = addr - reinterpret_cast<std::uint64_t>(info.dli_fbase);
+        if ( info.dli_sname ) {
+            names[addr] = demangle(info.dli_sname);
+        } else {
+            const char *slash = std::strrchr(info.dli_fname, '/');
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "+0x%llx", static_cast<unsigned long long>(offset));
+            names[addr] = std::string{slash ? slash + 1 : info.dli_fname} + buf;
+        }
+
+        auto it = modules.find(path);
+        if ( it == modules.end() ) {
+            it = modules.emplace(path, module_frames{is_relocatable(path), {}}).first;
+        }
+        it->second.addrs.emplace_back(addr, it->second.relocatable ? offset : addr);
+    }
+
+    for ( const auto &it: modules ) {
+        run_addr2line(it.first, it.second, &names);
+    }
+
+    return names;
+}
+
+// ';' separates the frames in the folded format
+std::string folded_frame(std::string name) {
+    for ( auto &ch: name ) {
+        if ( ch == ';' || ch == '\n' ) {
+            ch = ':';
+        }
+    }
+
+    return name;
+}
+
+} // anon ns
+
+perf_sampler::perf_sampler(std::size_t frequency)
+    :m_fd{-1}
+    ,m_buf{nullptr}
+    ,m_buf_size{}
+    ,m_error{}
+    ,m_samples{}
+    ,m_lost{}
+    ,m_stacks{}
+{
+    perf_event_attr attr;
+    init_attr(&attr, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, frequency);
+    m_fd = perf_event_open(&attr);
+    if ( m_fd == -1 ) {
+        // e.g. in the virtual machines without the PMU
+        init_attr(&attr, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, frequency);
+        m_fd = perf_event_open(&attr);
+    }
+    if ( m_fd == -1 ) {
+        m_error = "perf_event_open(): ";
+        m_error += std::strerror(errno);
+
+        return;
+    }
+
+    m_buf_size = (ring_data_pages + 1) * ::sysconf(_SC_PAGESIZE);
+    m_buf = ::mmap(nullptr, m_buf_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if ( m_buf == MAP_FAILED ) {
+        m_error = "mmap(): ";
+        m_error += std::strerror(errno);
+        m_buf = nullptr;
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+perf_sampler::~perf_sampler() {
+    if ( m_buf ) {
+        ::munmap(m_buf, m_buf_size);
+    }
+    if ( m_fd != -1 ) {
+        ::close(m_fd);
+    }
+}
+
+bool perf_sampler::available() const { return m_fd != -1; }
+
+const std::string& perf_sampler::error() const { return m_error; }
+
+void perf_sampler::enable() {
+    if ( available() ) {
+        ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_sampler::disable() {
+    if ( available() ) {
+        ::ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void perf_sampler::collect() {
+    if ( !available() ) {
+        return;
+    }
+
+    auto *meta = static_cast<perf_event_mmap_page *>(m_buf);
+    const auto *data = static_cast<const char *>(m_buf) + meta->data_offset;
+    const auto data_size = meta->data_size;
+    const auto head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    auto tail = meta->data_tail;
+
+    // the records may wrap around the end of the buffer
+    std::vector<char> record;
+    auto copy = [&](std::uint64_t pos, std::size_t size) {
+        record.resize(size);
+        for ( std::size_t done = 0; done < size; ) {
+            const auto off = (pos + done) % data_size;
+            const auto chunk = std::min<std::size_t>(size - done, data_size - off);
+            std::memcpy(record.data() + done, data + off, chunk);
+            done += chunk;
+        }
+    };
+
+    std::vector<std::uint64_t> stack;
+    while ( tail < head ) {
+        perf_event_header hdr;
+        copy(tail, sizeof(hdr));
+        std::memcpy(&hdr, record.data(), sizeof(hdr));
+        if ( hdr.size == 0 ) {
+            break;
+        }
+        copy(tail, hdr.size);
+
+        if ( hdr.type == PERF_RECORD_SAMPLE ) {
+            // header, ip, nr, ips[nr]
+            std::uint64_t nr;
+            std::memcpy(&nr, record.data() + sizeof(hdr) + sizeof(std::uint64_t), sizeof(nr));
+            const auto *ips = reinterpret_cast<const std::uint64_t *>(record.data() + sizeof(hdr) + 2 * sizeof(std::uint64_t));
+
+            stack.clear();
+            for ( auto i = 0u; i < nr; ++i ) {
+                std::uint64_t ip;
+                std::memcpy(&ip, ips + i, sizeof(ip));
+                // PERF_CONTEXT_USER and the like
+                if ( ip >= PERF_CONTEXT_MAX ) {
+                    continue;
+                }
+                // the return addresses point after the call instruction
+                stack.push_back(stack.empty() ? ip : ip - 1);
+            }
+            if ( !stack.empty() ) {
+                ++m_stacks[stack];
+                ++m_samples;
+            }
+        } else if ( hdr.type == PERF_RECORD_LOST ) {
+            // header, id, lost
+            std::uint64_t lost;
+            std::memcpy(&lost, record.data() + sizeof(hdr) + sizeof(std::uint64_t), sizeof(lost));
+            m_lost += lost;
+        }
+
+        tail += hdr.size;
+    }
+
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+std::pair<bool, std::string> perf_sampler::write_folded(const std::string &fname, const std::string &root) const {
+    std::set<std::uint64_t> addrs;
+    for ( const auto &it: m_stacks ) {
+        addrs.insert(it.first.begin(), it.first.end());
+    }
+    const auto names = symbolize(addrs);
+
+    // the stacks which differ in the addresses only are merged
+    std::map<std::string, std::uint64_t> folded;
+    for ( const auto &it: m_stacks ) {
+        auto line = folded_frame(root);
+        for ( auto frame = it.first.rbegin(); frame != it.first.rend(); ++frame ) {
+            line += ";";
+            line += folded_frame(names.at(*frame));
+        }
+        folded[line] += it.second;
+    }
+
+    std::ofstream os{fname};
+    if ( !os ) {
+        return {false, "can't create \"" + fname + "\": " + std::strerror(errno)};
+    }
+    for ( const auto &it: folded ) {
+        os << it.first << " " << it.second << std::endl;
+    }
+
+    return {os.good(), os.good() ? std::string{} : "can't write \"" + fname + "\""};
+}
+
+#else // !__linux__
+
+perf_sampler::perf_sampler(std::size_t)
+    :m_fd{-1}
+    ,m_buf{nullptr}
+    ,m_buf_size{}
+    ,m_error{"perf_event_open() is available on Linux only"}
+    ,m_samples{}
+    ,m_lost{}
+    ,m_stacks{}
+{}
+perf_sampler::~perf_sampler() {}
+bool perf_sampler::available() const { return false; }
+const std::string& perf_sampler::error() const { return m_error; }
+void perf_sampler::enable() {}
+void perf_sampler::disable() {}
+void perf_sampler::collect() {}
+std::pair<bool, std::string> perf_sampler::write_folded(const std::string &, const std::string &) const {
+    return {false, m_error};
+}
+
+#endif // __linux__
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
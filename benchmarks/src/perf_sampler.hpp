@@ -0,0 +1,64 @@
+#ifndef JSON_BENCHMARKS_PERF_SAMPLER_HPP
+#define JSON_BENCHMARKS_PERF_SAMPLER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+// the sampling profiler for the calling thread.
+// the user-space call stacks are sampled at 'frequency' Hz of the CPU cycles,
+// or of the CPU clock when the hardware event is not available, into the ring buffer
+// mapped by mmap(). the stacks are walked by the kernel using the frame pointers,
+// so the stacks are truncated at the first function compiled without them
+// (see ALLOC_BACKTRACES in CMakeLists.txt).
+struct perf_sampler {
+    explicit perf_sampler(std::size_t frequency);
+    ~perf_sampler();
+
+    perf_sampler(const perf_sampler &) = delete;
+    perf_sampler& operator= (const perf_sampler &) = delete;
+
+    bool available() const;
+    // the reason why the sampling is not available
+    const std::string& error() const;
+
+    // a single ioctl() each, may be called around a phase
+    void enable();
+    void disable();
+
+    // moves the samples from the ring buffer into the aggregated stacks.
+    // must be called often enough for the buffer not to overflow, and outside of the measured phases
+    // because it allocates.
+    void collect();
+
+    std::uint64_t samples() const { return m_samples; }
+    // the samples dropped by the kernel because the ring buffer was full
+    std::uint64_t lost() const { return m_lost; }
+
+    // writes the "root;outer;...;inner count" lines the flamegraph tools understand.
+    // the frames are symbolized by addr2line using the debug info of the binary and the shared objects,
+    // the frames without the debug info are named after the exported symbol or "module+0xoff"
+    std::pair<bool, std::string> write_folded(const std::string &fname, const std::string &root) const;
+
+private:
+    int m_fd;
+    void *m_buf;
+    std::size_t m_buf_size;
+    std::string m_error;
+    std::uint64_t m_samples;
+    std::uint64_t m_lost;
+    // the innermost frame first
+    std::map<std::vector<std::uint64_t>, std::uint64_t> m_stacks;
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_PERF_SAMPLER_HPP
@@ -0,0 +1,409 @@
+
+#include "results.hpp"
+#include "benchmarks.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+
+#include "jsoncons/json.hpp"
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+// the per-phase fields of 'measurements' in one place
+struct phase_view {
+    trial_phase phase;
+    std::uint64_t time;
+    const std::vector<std::uint64_t> *samples;
+    const sample_stats *stats;
+    std::size_t allocated;
+    std::size_t allocations;
+    std::size_t deallocations;
+    const perf_counters *counters;
+    const resource_usage *usage;
+    const alloc_profile *profile;
+    const std::vector<alloc_site> *sites; // nullptr when not collected for the phase
+};
+
+std::vector<phase_view> phases_of(const measurements &m) {
+    return {
+         {trial_phase::prepare, m.time_to_prepare, &m.prepare_samples, &m.prepare_stats
+            ,m.prepare_allocated, m.prepare_allocations, m.prepare_deallocations
+            ,&m.prepare_counters, &m.prepare_usage, &m.prepare_alloc_profile, nullptr}
+        ,{trial_phase::parse, m.time_to_parse, &m.parse_samples, &m.parse_stats
+            ,m.parse_allocated, m.parse_allocations, m.parse_deallocations
+            ,&m.parse_counters, &m.parse_usage, &m.parse_alloc_profile, &m.parse_alloc_sites}
+        ,{trial_phase::print, m.time_to_print, &m.print_samples, &m.print_stats
+            ,m.print_allocated, m.print_allocations, m.print_deallocations
+            ,&m.print_counters, &m.print_usage, &m.print_alloc_profile, &m.print_alloc_sites}
+        ,{trial_phase::free, m.time_to_free, &m.free_samples, &m.free_stats
+            ,0, 0, m.free_deallocations
+            ,&m.free_counters, &m.free_usage, &m.free_alloc_profile, nullptr}
+    };
+}
+
+template<typename T, std::size_t N>
+jsoncons::json to_json_array(const T (&arr)[N]) {
+    jsoncons::json res(jsoncons::json_array_arg);
+    for ( const auto &it: arr ) {
+        res.push_back(it);
+    }
+
+    return res;
+}
+
+template<typename T>
+jsoncons::json to_json_array(const std::vector<T> &vec) {
+    jsoncons::json res(jsoncons::json_array_arg);
+    for ( const auto &it: vec ) {
+        res.push_back(it);
+    }
+
+    return res;
+}
+
+jsoncons::json to_json(const sample_stats &s) {
+    jsoncons::json res;
+    res["count"] = s.count;
+    res["outliers"] = s.outliers;
+    res["min"] = s.min;
+    res["median"] = s.median;
+    res["mean"] = s.mean;
+    res["p90"] = s.p90;
+    res["p99"] = s.p99;
+    res["stddev"] = s.stddev;
+    res["mad"] = s.mad;
+    res["ci_low"] = s.ci_low;
+    res["ci_high"] = s.ci_high;
+
+    return res;
+}
+
+// the unavailable counters are null
+jsoncons::json to_json(const perf_counters &c) {
+    jsoncons::json res;
+    for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+        const auto ev = static_cast<perf_event>(i);
+        res[perf_event_name(ev)] = c.is_valid(ev)
+            ? jsoncons::json(c.get(ev))
+            : jsoncons::json(jsoncons::null_type{})
+        ;
+    }
+
+    return res;
+}
+
+jsoncons::json to_json(const resource_usage &u) {
+    jsoncons::json res;
+    res["minor_faults"] = u.minor_faults;
+    res["major_faults"] = u.major_faults;
+    res["user_time_ns"] = u.user_time_ns;
+    res["sys_time_ns"] = u.sys_time_ns;
+    res["voluntary_switches"] = u.voluntary_switches;
+    res["involuntary_switches"] = u.involuntary_switches;
+    res["rss_before"] = u.rss_before;
+    res["rss_after"] = u.rss_after;
+
+    return res;
+}
+
+jsoncons::json to_json(const alloc_profile &p) {
+    if ( !p.collected ) {
+        return jsoncons::json(jsoncons::null_type{});
+    }
+
+    jsoncons::json res;
+    res["allocations"] = p.allocations;
+    res["untracked"] = p.untracked;
+    res["freed"] = p.freed;
+    res["live_at_start"] = p.live_at_start;
+    res["peak_live_bytes"] = p.peak_live_bytes;
+    res["size_histogram"] = to_json_array(p.size_histogram);
+    res["lifetime_histogram"] = to_json_array(p.lifetime_histogram);
+
+    return res;
+}
+
+jsoncons::json to_json(const std::vector<alloc_site> &sites) {
+    jsoncons::json res(jsoncons::json_array_arg);
+    for ( const auto &it: sites ) {
+        jsoncons::json site;
+        site["stack"] = it.stack;
+        site["bytes"] = it.bytes;
+        site["allocations"] = it.allocations;
+        res.push_back(std::move(site));
+    }
+
+    return res;
+}
+
+jsoncons::json to_json(const benchmarks *impl, const measurements &m) {
+    jsoncons::json res;
+    res["name"] = m.name;
+    res["version"] = impl->version();
+    res["errmsg"] = m.errmsg;
+    res["input_size"] = m.input_size;
+    res["output_size"] = m.output_size;
+    res["json_values"] = m.json_values;
+    res["warmups"] = m.warmups;
+    res["converged"] = m.converged;
+    res["leaks_as_expected"] = m.leaks_as_expected;
+    res["first_trial_time"] = m.first_trial_time;
+    res["first_trial_allocated"] = m.first_trial_allocated;
+    res["first_trial_allocations"] = m.first_trial_allocations;
+    if ( !m.sax_parse_samples.empty() ) {
+        jsoncons::json sax;
+        sax["time"] = m.time_to_sax_parse;
+        sax["samples"] = to_json_array(m.sax_parse_samples);
+        sax["stats"] = to_json(m.sax_parse_stats);
+        sax["allocated"] = m.sax_parse_allocated;
+        sax["allocations"] = m.sax_parse_allocations;
+        sax["events"] = m.sax_events;
+        sax["numbers"] = m.sax_numbers;
+        sax["throughput_mbs"] = m.sax_parse_throughput();
+        res["sax_parse"] = std::move(sax);
+    }
+    if ( !m.chunked.empty() ) {
+        jsoncons::json chunked(jsoncons::json_array_arg);
+        for ( const auto &it: m.chunked ) {
+            jsoncons::json c;
+            c["chunk_size"] = it.chunk_size;
+            c["samples"] = to_json_array(it.samples);
+            c["stats"] = to_json(it.stats);
+            c["throughput_mbs"] = it.throughput(m.input_size);
+            c["chunk_p50"] = it.chunk_p50;
+            c["chunk_p99"] = it.chunk_p99;
+            c["chunk_max"] = it.chunk_max;
+            c["allocated"] = it.allocated;
+            c["allocations"] = it.allocations;
+            chunked.push_back(std::move(c));
+        }
+        res["chunked"] = std::move(chunked);
+    }
+    if ( !m.traversed.empty() ) {
+        jsoncons::json traversed(jsoncons::json_array_arg);
+        for ( const auto &it: m.traversed ) {
+            jsoncons::json t;
+            t["pattern"] = traverse_pattern_name(static_cast<traverse_pattern>(it.pattern));
+            t["samples"] = to_json_array(it.samples);
+            t["stats"] = to_json(it.stats);
+            t["allocated"] = it.allocated;
+            t["allocations"] = it.allocations;
+            t["values"] = it.values;
+            t["strings"] = it.strings;
+            t["numbers"] = it.numbers;
+            t["ns_per_value"] = it.ns_per_value();
+            traversed.push_back(std::move(t));
+        }
+        res["traversed"] = std::move(traversed);
+    }
+    res["free_deallocated"] = m.free_deallocated;
+    res["free_leaked_bytes"] = m.free_leaked_bytes;
+    res["free_leaked_allocations"] = m.free_leaked_allocations;
+    res["parse_throughput_mbs"] = m.parse_throughput();
+    res["print_throughput_mbs"] = m.print_throughput();
+    res["parse_ns_per_value"] = m.parse_ns_per_value();
+    res["print_ns_per_value"] = m.print_ns_per_value();
+
+    jsoncons::json phases;
+    for ( const auto &it: phases_of(m) ) {
+        jsoncons::json ph;
+        ph["time"] = it.time;
+        ph["samples"] = to_json_array(*it.samples);
+        ph["stats"] = to_json(*it.stats);
+        ph["allocated"] = it.allocated;
+        ph["allocations"] = it.allocations;
+        ph["deallocations"] = it.deallocations;
+        ph["counters"] = to_json(*it.counters);
+        ph["usage"] = to_json(*it.usage);
+        ph["alloc_profile"] = to_json(*it.profile);
+        if ( it.sites ) {
+            ph["alloc_sites"] = to_json(*it.sites);
+        }
+        phases[trial_phase_name(it.phase)] = std::move(ph);
+    }
+    res["phases"] = std::move(phases);
+
+    jsoncons::json timeline(jsoncons::json_array_arg);
+    for ( const auto &it: m.alloc_timeline ) {
+        jsoncons::json point;
+        point["allocation"] = it.allocation;
+        point["phase"] = trial_phase_name(static_cast<trial_phase>(it.phase));
+        point["live_bytes"] = it.live_bytes;
+        timeline.push_back(std::move(point));
+    }
+    res["alloc_timeline"] = std::move(timeline);
+
+    return res;
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
+std::pair<bool, std::string> write_results_json(
+     const std::string &fname
+    ,const run_environment &env
+    ,const benchmark_results &results)
+{
+    jsoncons::json root;
+
+    jsoncons::json environment;
+    for ( const auto &[name, value]: env ) {
+        environment[name] = value;
+    }
+    root["environment"] = std::move(environment);
+
+    jsoncons::json libraries(jsoncons::json_array_arg);
+    for ( const auto &[impl, stat]: results ) {
+        libraries.push_back(to_json(impl, stat));
+    }
+    root["results"] = std::move(libraries);
+
+    std::ofstream os{fname};
+    if ( !os ) {
+        return {false, "can't create \"" + fname + "\": " + std::strerror(errno)};
+    }
+    os << jsoncons::pretty_print(root) << std::endl;
+
+    return {os.good(), os.good() ? std::string{} : "can't write \"" + fname + "\""};
+}
+
+std::pair<bool, std::string> write_results_csv(
+     const std::string &fname
+    ,const benchmark_results &results)
+{
+    std::ofstream os{fname};
+    if ( !os ) {
+        return {false, "can't create \"" + fname + "\": " + std::strerror(errno)};
+    }
+
+    os << "library,version,phase,median_ns,min_ns,mean_ns,p90_ns,p99_ns,stddev_ns,mad_ns,ci_low_ns,ci_high_ns"
+          ",samples,outliers,allocated,allocations,deallocations,peak_live_bytes";
+    for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+        os << "," << perf_event_name(static_cast<perf_event>(i));
+    }
+    os << ",minor_faults,major_faults,user_time_ns,sys_time_ns" << std::endl;
+
+    for ( const auto &[impl, stat]: results ) {
+        for ( const auto &it: phases_of(stat) ) {
+            const auto &s = *it.stats;
+            os
+                << stat.name
+                << "," << impl->version()
+                << "," << trial_phase_name(it.phase)
+                << "," << it.time
+                << "," << s.min
+                << "," << s.mean
+                << "," << s.p90
+                << "," << s.p99
+                << "," << s.stddev
+                << "," << s.mad
+                << "," << s.ci_low
+                << "," << s.ci_high
+                << "," << s.count
+                << "," << s.outliers
+                << "," << it.allocated
+                << "," << it.allocations
+                << "," << it.deallocations
+                << ","
+            ;
+            if ( it.profile->collected ) {
+                os << it.profile->peak_live_bytes;
+            }
+            // the unavailable values are empty
+            for ( auto i = 0u; i < static_cast<std::size_t>(perf_event::count_); ++i ) {
+                os << ",";
+                if ( it.counters->is_valid(static_cast<perf_event>(i)) ) {
+                    os << it.counters->get(static_cast<perf_event>(i));
+                }
+            }
+            os
+                << "," << it.usage->minor_faults
+                << "," << it.usage->major_faults
+                << "," << it.usage->user_time_ns
+                << "," << it.usage->sys_time_ns
+                << std::endl
+            ;
+        }
+    }
+
+    return {os.good(), os.good() ? std::string{} : "can't write \"" + fname + "\""};
+}
+
+/*************************************************************************************************/
+
+std::pair<bool, std::string> compare_with_baseline(
+     std::vector<regression> *regressions
+    ,const std::string &baseline_fname
+    ,const benchmark_results &results
+    ,const regression_thresholds &thresholds)
+{
+    std::ifstream is{baseline_fname};
+    if ( !is ) {
+        return {false, "can't open the baseline \"" + baseline_fname + "\": " + std::strerror(errno)};
+    }
+
+    jsoncons::json baseline;
+    try {
+        baseline = jsoncons::json::parse(is);
+    } catch (const std::exception &e) {
+        return {false, "can't parse the baseline \"" + baseline_fname + "\": " + e.what()};
+    }
+    if ( !baseline.contains("results") ) {
+        return {false, "the baseline \"" + baseline_fname + "\" has no results"};
+    }
+
+    for ( const auto &[impl, stat]: results ) {
+        const jsoncons::json *base = nullptr;
+        for ( const auto &it: baseline.at("results").array_range() ) {
+            if ( it.at("name").as<std::string>() == stat.name ) {
+                base = &it;
+                break;
+            }
+        }
+        if ( !base ) {
+            continue;
+        }
+
+        for ( const auto &it: phases_of(stat) ) {
+            const auto *phase = trial_phase_name(it.phase);
+            if ( !base->at("phases").contains(phase) ) {
+                continue;
+            }
+            const auto &bph = base->at("phases").at(phase);
+
+            auto check = [&](const char *metric, double bvalue, double cvalue, double threshold) {
+                if ( cvalue > bvalue * (1.0 + threshold) ) {
+                    regressions->push_back({stat.name, phase, metric, bvalue, cvalue});
+                }
+            };
+
+            // the noise is not a regression
+            const auto &bstats = bph.at("stats");
+            if ( it.stats->ci_low > bstats.at("ci_high").as<double>() ) {
+                check("median time ns", bstats.at("median").as<double>(), it.stats->median, thresholds.time);
+            }
+
+            check("allocations", bph.at("allocations").as<double>(), it.allocations, thresholds.allocations);
+
+            if ( it.profile->collected && !bph.at("alloc_profile").is_null() ) {
+                check("peak live bytes"
+                    ,bph.at("alloc_profile").at("peak_live_bytes").as<double>()
+                    ,it.profile->peak_live_bytes
+                    ,thresholds.peak
+                );
+            }
+        }
+    }
+
+    return {true, std::string{}};
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,64 @@
+#ifndef JSON_BENCHMARKS_RESULTS_HPP
+#define JSON_BENCHMARKS_RESULTS_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "measurements.hpp"
+
+namespace json_benchmarks {
+
+struct benchmarks;
+
+/*************************************************************************************************/
+
+using benchmark_results = std::vector<std::pair<const benchmarks *, measurements>>;
+// the name/value pairs describing the machine, the input and the options of the run
+using run_environment = std::vector<std::pair<std::string, std::string>>;
+
+// the machine-readable copies of the report.
+// the JSON contains every field of 'measurements' and the environment,
+// the CSV has one row for each library and phase.
+std::pair<bool, std::string> write_results_json(
+     const std::string &fname
+    ,const run_environment &env
+    ,const benchmark_results &results
+);
+std::pair<bool, std::string> write_results_csv(
+     const std::string &fname
+    ,const benchmark_results &results
+);
+
+/*************************************************************************************************/
+
+// the allowed relative growth, 0.05 means +5%
+struct regression_thresholds {
+    double time;
+    double allocations;
+    double peak;
+};
+
+struct regression {
+    std::string library;
+    std::string phase;
+    std::string metric;
+    double baseline;
+    double current;
+};
+
+// compares the results with the JSON written by write_results_json() before.
+// the time is reported only when the CIs of the medians don't overlap,
+// the libraries and the metrics missing on either side are skipped.
+std::pair<bool, std::string> compare_with_baseline(
+     std::vector<regression> *regressions
+    ,const std::string &baseline_fname
+    ,const benchmark_results &results
+    ,const regression_thresholds &thresholds
+);
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_RESULTS_HPP
@@ -0,0 +1,291 @@
+
+#include "scaling.hpp"
+#include "benchmarks.hpp"
+#include "timer.hpp"
+
+#include <ostream>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+const char* placement_policy_name(placement_policy p) {
+    switch ( p ) {
+        case placement_policy::compact: return "compact";
+        case placement_policy::spread: return "spread";
+        case placement_policy::smt: return "smt";
+        case placement_policy::bandwidth: return "bandwidth";
+        case placement_policy::count_: break;
+    }
+
+    return "UNKNOWN";
+}
+
+std::ostream& operator<< (std::ostream &os, placement_policy p) {
+    return os << placement_policy_name(p);
+}
+
+std::vector<int> placement_order(placement_policy p, const std::vector<cpu_location> &topology) {
+    // package -> cores -> CPUs, in the order of the CPU numbers
+    std::map<int, std::vector<std::vector<int>>> packages;
+    std::map<std::pair<int, int>, std::size_t> core_index;
+    std::size_t max_siblings = 0;
+    for ( const auto &it: topology ) {
+        auto &cores = packages[it.package];
+        auto pos = core_index.find({it.package, it.core});
+        if ( pos == core_index.end() ) {
+            pos = core_index.emplace(std::make_pair(it.package, it.core), cores.size()).first;
+            cores.emplace_back();
+        }
+        cores[pos->second].push_back(it.cpu);
+        max_siblings = std::max(max_siblings, cores[pos->second].size());
+    }
+
+    std::vector<int> res;
+    switch ( p ) {
+        case placement_policy::compact: {
+            for ( const auto &[package, cores]: packages ) {
+                for ( auto sibling = 0u; sibling < max_siblings; ++sibling ) {
+                    for ( const auto &cpus: cores ) {
+                        if ( sibling < cpus.size() ) {
+                            res.push_back(cpus[sibling]);
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case placement_policy::spread:
+        case placement_policy::bandwidth: {
+            std::size_t max_cores = 0;
+            for ( const auto &it: packages ) {
+                max_cores = std::max(max_cores, it.second.size());
+            }
+            for ( auto sibling = 0u; sibling < max_siblings; ++sibling ) {
+                for ( auto core = 0u; core < max_cores; ++core ) {
+                    for ( const auto &[package, cores]: packages ) {
+                        if ( core < cores.size() && sibling < cores[core].size() ) {
+                            res.push_back(cores[core][sibling]);
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case placement_policy::smt: {
+            for ( const auto &[package, cores]: packages ) {
+                for ( const auto &cpus: cores ) {
+                    res.insert(res.end(), cpus.begin(), cpus.end());
+                }
+            }
+            break;
+        }
+        case placement_policy::count_: break;
+    }
+
+    return res;
+}
+
+/*************************************************************************************************/
+
+namespace {
+
+// the state shared by the threads of one step
+struct step_state {
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop_hogs{false};
+};
+
+struct thread_result {
+    std::string errmsg;
+    std::vector<std::uint64_t> parse_samples;
+    std::vector<std::uint64_t> print_samples;
+    std::size_t input_size = 0;
+    std::size_t output_size = 0;
+};
+
+void wait_for_start(step_state *state) {
+    ++state->ready;
+    while ( !state->go.load(std::memory_order_acquire) ) {
+        std::this_thread::yield();
+    }
+}
+
+// streams through the buffer larger than its share of the LLC until stopped
+void memory_hog(step_state *state, int cpu) {
+    pin_to_cpu(cpu);
+
+    std::vector<char> buffer(16u * 1024u * 1024u);
+    wait_for_start(state);
+
+    volatile char *ptr = buffer.data();
+    while ( !state->stop_hogs.load(std::memory_order_relaxed) ) {
+        for ( std::size_t i = 0; i < buffer.size(); i += 64 ) {
+            ptr[i] = static_cast<char>(ptr[i] + 1);
+        }
+    }
+}
+
+void worker(
+     thread_result *res
+    ,step_state *state
+    ,benchmarks *impl
+    ,io_device *shared_input
+    ,const std::string &input_fname
+    ,int cpu
+    ,const scaling_options &opts)
+{
+    auto emsg = pin_to_cpu(cpu);
+    if ( !emsg.empty() ) {
+        res->errmsg = "can't pin to cpu " + std::to_string(cpu) + ": " + emsg;
+    }
+
+    auto [input_io, output_io] = impl->create_io(input_fname);
+    io_device *input = shared_input ? shared_input : input_io.get();
+    res->input_size = input->size();
+    res->parse_samples.reserve(opts.iterations);
+    res->print_samples.reserve(opts.iterations);
+
+    auto trial = [&](bool measured) {
+        output_io->reset();
+        output_io->reserve(input->size() * 2);
+
+        impl->prepare(input, opts.json_flags);
+        auto start = impl->start_time();
+        auto parse_res = impl->parse(input, opts.json_flags);
+        auto parse_time = impl->duration(start);
+        if ( !parse_res.first ) {
+            res->errmsg = "the PARSE benchmark for \"" + std::string{impl->name()} + "\" finished with error: " + parse_res.second;
+
+            return false;
+        }
+        start = impl->start_time();
+        auto print_res = impl->print(output_io.get(), opts.json_flags);
+        auto print_time = impl->duration(start);
+        res->output_size = output_io->size();
+        impl->finish();
+        reset_allocator();
+        if ( !print_res.first ) {
+            res->errmsg = "the PRINT benchmark for \"" + std::string{impl->name()} + "\" finished with error: " + print_res.second;
+
+            return false;
+        }
+
+        if ( measured ) {
+            res->parse_samples.push_back(parse_time);
+            res->print_samples.push_back(print_time);
+        }
+
+        return true;
+    };
+
+    bool ok = res->errmsg.empty();
+    for ( std::size_t i = 0; ok && i < opts.warmups; ++i ) {
+        ok = trial(false);
+    }
+    // the failed thread still has to pass the barrier
+    wait_for_start(state);
+    for ( std::size_t i = 0; ok && i < opts.iterations; ++i ) {
+        ok = trial(true);
+    }
+    impl->release();
+}
+
+std::uint64_t median(std::vector<std::uint64_t> *samples) {
+    if ( samples->empty() ) {
+        return 0;
+    }
+    auto mid = samples->begin() + samples->size() / 2;
+    std::nth_element(samples->begin(), mid, samples->end());
+
+    return *mid;
+}
+
+} // anon ns
+
+std::pair<bool, std::string> run_scaling_step(
+     scaling_point *res
+    ,benchmarks *impl
+    ,const std::string &input_fname
+    ,std::size_t threads
+    ,const scaling_options &opts)
+{
+    const auto order = placement_order(opts.placement, get_cpu_topology());
+    if ( order.empty() ) {
+        return {false, "can't get the CPU topology"};
+    }
+    if ( threads > order.size() ) {
+        return {false, std::to_string(threads) + " threads requested but only " + std::to_string(order.size()) + " CPUs are available"};
+    }
+
+    std::unique_ptr<io_device> shared_input;
+    if ( opts.shared_input ) {
+        shared_input = impl->create_io(input_fname).first;
+    }
+
+    step_state state;
+    std::vector<thread_result> results(threads);
+    std::vector<std::thread> workers;
+    for ( std::size_t i = 0; i < threads; ++i ) {
+        workers.emplace_back(worker, &results[i], &state, impl, shared_input.get(), std::cref(input_fname), order[i], std::cref(opts));
+    }
+    std::vector<std::thread> hogs;
+    if ( opts.placement == placement_policy::bandwidth ) {
+        for ( std::size_t i = threads; i < order.size(); ++i ) {
+            hogs.emplace_back(memory_hog, &state, order[i]);
+        }
+    }
+
+    while ( state.ready.load() != workers.size() + hogs.size() ) {
+        std::this_thread::yield();
+    }
+    state.go.store(true, std::memory_order_release);
+
+    for ( auto &it: workers ) {
+        it.join();
+    }
+    state.stop_hogs.store(true);
+    for ( auto &it: hogs ) {
+        it.join();
+    }
+
+    res->threads = threads;
+    res->memory_hogs = hogs.size();
+    res->parse_mbs = 0.0;
+    res->print_mbs = 0.0;
+    std::vector<std::uint64_t> parse_samples, print_samples;
+    for ( auto &it: results ) {
+        if ( !it.errmsg.empty() ) {
+            return {false, it.errmsg};
+        }
+
+        std::uint64_t parse_ns = 0, print_ns = 0;
+        for ( auto ns: it.parse_samples ) {
+            parse_ns += ns;
+        }
+        for ( auto ns: it.print_samples ) {
+            print_ns += ns;
+        }
+        // bytes per nanosecond * 1000 = MB/s, the print throughput is of the output as in 'measurements'
+        const double parsed = static_cast<double>(it.input_size) * it.parse_samples.size();
+        const double printed = static_cast<double>(it.output_size) * it.print_samples.size();
+        res->parse_mbs += parse_ns ? parsed * 1000.0 / parse_ns : 0.0;
+        res->print_mbs += print_ns ? printed * 1000.0 / print_ns : 0.0;
+
+        parse_samples.insert(parse_samples.end(), it.parse_samples.begin(), it.parse_samples.end());
+        print_samples.insert(print_samples.end(), it.print_samples.begin(), it.print_samples.end());
+    }
+    res->parse_median_ns = median(&parse_samples);
+    res->print_median_ns = median(&print_samples);
+
+    return {true, std::string{}};
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,66 @@
+#ifndef JSON_BENCHMARKS_SCALING_HPP
+#define JSON_BENCHMARKS_SCALING_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+#include <cstdint>
+
+#include "os_tools.hpp"
+
+namespace json_benchmarks {
+
+struct benchmarks;
+
+/*************************************************************************************************/
+
+enum class placement_policy {
+     compact   // one package first, one thread per core, then the SMT siblings
+    ,spread    // the packages in turn, one thread per core, then the SMT siblings
+    ,smt       // both SMT siblings of a core before the next core
+    ,bandwidth // as 'spread', and the rest of the CPUs stream through the memory meanwhile
+    ,count_    // must be the last
+};
+
+const char* placement_policy_name(placement_policy p);
+std::ostream& operator<< (std::ostream &os, placement_policy p);
+
+// the CPUs in the order the threads are placed on them
+std::vector<int> placement_order(placement_policy p, const std::vector<cpu_location> &topology);
+
+struct scaling_options {
+    placement_policy placement;
+    std::size_t warmups;    // untimed trials of each thread
+    std::size_t iterations; // measured trials of each thread
+    std::size_t json_flags;
+    bool shared_input;      // all the threads parse the same mapped input
+};
+
+// the throughput of 'threads' parsing at once
+struct scaling_point {
+    std::size_t threads;
+    std::size_t memory_hogs; // the threads streaming through the memory, the bandwidth policy only
+    double parse_mbs;        // the sum of the throughput of the threads
+    double print_mbs;
+    std::uint64_t parse_median_ns; // over the trials of all the threads
+    std::uint64_t print_median_ns;
+};
+
+// starts 'threads' threads pinned according to 'opts.placement', each of them runs
+// prepare/parse/print/finish with its own output and, unless 'opts.shared_input', its own input.
+// the measured trials of all the threads start at once, after the warmups.
+// the adapters keep their state in thread_local variables, so one 'impl' is shared.
+std::pair<bool, std::string> run_scaling_step(
+     scaling_point *res
+    ,benchmarks *impl
+    ,const std::string &input_fname
+    ,std::size_t threads
+    ,const scaling_options &opts
+);
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_SCALING_HPP
@@ -0,0 +1,148 @@
+
+#include "stats.hpp"
+#include "measurements.hpp"
+
+#include <algorithm>
+#include <random>
+#include <ostream>
+#include <cmath>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+// 'sorted' must be sorted in ascending order, 'p' is in [0..1]
+double percentile(const std::vector<double> &sorted, double p) {
+    if ( sorted.empty() ) {
+        return 0.0;
+    }
+
+    double pos = p * (sorted.size() - 1);
+    auto lo = static_cast<std::size_t>(std::floor(pos));
+    auto hi = static_cast<std::size_t>(std::ceil(pos));
+    double frac = pos - lo;
+
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+}
+
+double median_of(std::vector<double> &v) {
+    auto mid = v.begin() + v.size() / 2;
+    std::nth_element(v.begin(), mid, v.end());
+    double m = *mid;
+    if ( v.size() % 2 == 0 ) {
+        m = (m + *std::max_element(v.begin(), mid)) / 2.0;
+    }
+
+    return m;
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
+sample_stats compute_stats(
+     const std::vector<std::uint64_t> &samples
+    ,std::size_t bootstrap_resamples
+    ,double confidence)
+{
+    sample_stats res;
+    if ( samples.empty() ) {
+        return res;
+    }
+
+    std::vector<double> all(samples.begin(), samples.end());
+    std::sort(all.begin(), all.end());
+
+    // outliers rejection using the scaled MAD of the raw samples
+    std::vector<double> tmp = all;
+    double raw_median = median_of(tmp);
+    for ( auto &it: tmp ) {
+        it = std::fabs(it - raw_median);
+    }
+    double raw_mad = median_of(tmp) * 1.4826;
+
+    std::vector<double> sorted;
+    sorted.reserve(all.size());
+    for ( auto it: all ) {
+        if ( raw_mad == 0.0 || std::fabs(it - raw_median) <= 3.5 * raw_mad ) {
+            sorted.push_back(it);
+        }
+    }
+
+    res.count    = sorted.size();
+    res.outliers = all.size() - sorted.size();
+    res.min      = sorted.front();
+    res.median   = percentile(sorted, 0.5);
+    res.p90      = percentile(sorted, 0.9);
+    res.p99      = percentile(sorted, 0.99);
+
+    double sum = 0.0;
+    for ( auto it: sorted ) {
+        sum += it;
+    }
+    res.mean = sum / sorted.size();
+
+    double sqsum = 0.0;
+    for ( auto it: sorted ) {
+        sqsum += (it - res.mean) * (it - res.mean);
+    }
+    res.stddev = sorted.size() > 1 ? std::sqrt(sqsum / (sorted.size() - 1)) : 0.0;
+
+    tmp.assign(sorted.begin(), sorted.end());
+    for ( auto &it: tmp ) {
+        it = std::fabs(it - res.median);
+    }
+    res.mad = median_of(tmp);
+
+    // percentile bootstrap of the median.
+    // the seed is fixed so the same samples always give the same interval.
+    if ( sorted.size() < 2 || bootstrap_resamples == 0 ) {
+        res.ci_low  = res.median;
+        res.ci_high = res.median;
+
+        return res;
+    }
+
+    std::mt19937_64 rng{0x6a736f6e};
+    std::uniform_int_distribution<std::size_t> dist{0, sorted.size() - 1};
+    std::vector<double> medians;
+    medians.reserve(bootstrap_resamples);
+    for ( auto i = 0u; i < bootstrap_resamples; ++i ) {
+        for ( auto &it: tmp ) {
+            it = sorted[dist(rng)];
+        }
+        medians.push_back(median_of(tmp));
+    }
+    std::sort(medians.begin(), medians.end());
+
+    double alpha = (1.0 - confidence) / 2.0;
+    res.ci_low  = percentile(medians, alpha);
+    res.ci_high = percentile(medians, 1.0 - alpha);
+
+    return res;
+}
+
+/*************************************************************************************************/
+
+std::ostream& operator<< (std::ostream &os, const sample_stats &s) {
+    auto t = [](double ns) { return human_time(static_cast<std::uint64_t>(ns)); };
+
+    return os
+        << "min: " << t(s.min)
+        << ", median: " << t(s.median)
+        << ", mean: " << t(s.mean)
+        << ", p90: " << t(s.p90)
+        << ", p99: " << t(s.p99)
+        << ", stddev: " << t(s.stddev)
+        << ", MAD: " << t(s.mad)
+        << ", CI: [" << t(s.ci_low) << " .. " << t(s.ci_high) << "]"
+        << ", n: " << s.count
+        << ", outliers: " << s.outliers
+    ;
+}
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,60 @@
+#ifndef JSON_BENCHMARKS_STATS_HPP
+#define JSON_BENCHMARKS_STATS_HPP
+
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+// summary of the per-trial samples of one phase.
+// the samples outside of 'median +/- 3.5 * scaled MAD' are rejected as outliers
+// before any of the values below is computed.
+struct sample_stats {
+    std::size_t count;    // number of the samples used
+    std::size_t outliers; // number of the rejected samples
+    double min;
+    double median;
+    double mean;
+    double p90;
+    double p99;
+    double stddev;
+    double mad;           // median absolute deviation
+    double ci_low;        // bootstrap confidence interval of the median
+    double ci_high;
+
+    sample_stats()
+        :count{}
+        ,outliers{}
+        ,min{}
+        ,median{}
+        ,mean{}
+        ,p90{}
+        ,p99{}
+        ,stddev{}
+        ,mad{}
+        ,ci_low{}
+        ,ci_high{}
+    {}
+
+    // relative half-width of the confidence interval, 0.05 means +/-5% of the median
+    double ci_rel_halfwidth() const {
+        return median > 0 ? (ci_high - ci_low) / 2.0 / median : 0.0;
+    }
+
+    friend std::ostream& operator<< (std::ostream &os, const sample_stats &s);
+};
+
+sample_stats compute_stats(
+     const std::vector<std::uint64_t> &samples
+    ,std::size_t bootstrap_resamples = 1000
+    ,double confidence = 0.95
+);
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_STATS_HPP
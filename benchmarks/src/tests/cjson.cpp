@@ -26,7 +26,20 @@ const char* cjson_benchmarks::notes() const {
     ;
 }
 
-static cJSON *local_obj = nullptr;
+static thread_local cJSON *local_obj = nullptr;
+
+bool cjson_benchmarks::supports_allocator(allocator_kind /*k*/) const { return true; }
+
+// the hooks are global, so they are switched with the allocator kind and not by prepare(),
+// which is called by each thread of the scaling benchmark. nullptr restores malloc()/free()
+static const bool hooks_listener = add_allocator_listener([](allocator_kind k) {
+    if ( k == allocator_kind::system ) {
+        cJSON_InitHooks(nullptr);
+    } else {
+        cJSON_Hooks hooks{harness_malloc, harness_free};
+        cJSON_InitHooks(&hooks);
+    }
+});
 
 void cjson_benchmarks::prepare(io_device */*in*/, std::size_t /*flags*/) const {
 
@@ -75,6 +88,93 @@ void cjson_benchmarks::finish() const {
     local_obj = nullptr;
 }
 
+namespace {
+
+void cjson_dfs(const cJSON *val, traverse_totals *totals) {
+    ++totals->values;
+    if ( cJSON_IsNumber(val) ) {
+        totals->numbers += val->valuedouble;
+    } else if ( cJSON_IsString(val) ) {
+        totals->strings += std::strlen(val->valuestring);
+    } else if ( cJSON_IsArray(val) || cJSON_IsObject(val) ) {
+        const bool object = cJSON_IsObject(val);
+        for ( const cJSON *it = val->child; it; it = it->next ) {
+            if ( object ) {
+                totals->strings += std::strlen(it->string);
+            }
+            cjson_dfs(it, totals);
+        }
+    }
+}
+
+// cJSON_GetObjectItemCaseSensitive() returns nullptr for nullptr, so the lookups are chained as is
+const cJSON* cjson_favorites(const cJSON *item) {
+    return cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(item, "person"), "favorites");
+}
+
+} // anon ns
+
+bool cjson_benchmarks::supports_traverse() const { return true; }
+
+// the items are the linked lists, so each lookup is the linear search
+// and cJSON_GetArrayItem() walks the array from the first item
+std::pair<bool, std::string>
+cjson_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    const cJSON *root = local_obj;
+    if ( p == traverse_pattern::dfs ) {
+        cjson_dfs(root, totals);
+
+        return {true, std::string{}};
+    }
+    if ( !cJSON_IsArray(root) ) {
+        return {true, std::string{}};
+    }
+
+    const cJSON *item;
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            cJSON_ArrayForEach(item, root) {
+                const auto *color = cJSON_GetObjectItemCaseSensitive(cjson_favorites(item), "color");
+                if ( cJSON_IsString(color) ) {
+                    ++totals->values;
+                    totals->strings += std::strlen(color->valuestring);
+                }
+            }
+            break;
+        }
+        case traverse_pattern::arrays: {
+            cJSON_ArrayForEach(item, root) {
+                const auto *favorites = cjson_favorites(item);
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    const auto *values = cJSON_GetObjectItemCaseSensitive(favorites, key);
+                    const cJSON *it;
+                    cJSON_ArrayForEach(it, values) {
+                        ++totals->values;
+                        totals->numbers += it->valuedouble;
+                    }
+                }
+            }
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = static_cast<std::size_t>(cJSON_GetArraySize(root));
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                item = cJSON_GetArrayItem(root, static_cast<int>(random_index(i, size)));
+                const auto *salary = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(item, "person"), "salary");
+                if ( cJSON_IsNumber(salary) ) {
+                    ++totals->values;
+                    totals->numbers += salary->valuedouble;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
+}
+
 //std::vector<test_suite_result> cjson_benchmarks::run_test_suite(std::vector<test_suite_file>& pathnames)
 //{
 //    std::vector<test_suite_result> results;
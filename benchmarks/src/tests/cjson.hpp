@@ -15,6 +15,11 @@ struct cjson_benchmarks: benchmarks {
     std::pair<bool, std::string> print(io_device *out, std::size_t flags) override;
     void finish() const override;
 
+    bool supports_allocator(allocator_kind k) const override;
+
+    bool supports_traverse() const override;
+    std::pair<bool, std::string> traverse(traverse_pattern p, traverse_totals *totals) override;
+
 //    test_suite_results run_test_suite(const test_suite_files &pathnames) override;
 
     io_type input_io_type() const override;
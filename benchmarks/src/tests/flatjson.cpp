@@ -4,11 +4,20 @@
 
 #include <flatjson/flatjson.hpp>
 
+#include <charconv>
+#include <cstring>
+
 namespace json_benchmarks {
 
 io_type flatjson_benchmarks::input_io_type() const { return io_type::mmap_streams; }
 io_type flatjson_benchmarks::output_io_type() const { return io_type::string_buffer; }
 
+// the parser is allocated over the input in prepare(), so only the devices holding the whole input
+// in memory are listed: for the stream ones the reading wouldn't be measured.
+// the output is serialized into the reserved string only.
+std::vector<io_type> flatjson_benchmarks::input_io_types() const
+{ return {io_type::string_buffer, io_type::mmap_streams}; }
+
 const char* flatjson_benchmarks::name() const { return "flatjson"; }
 
 const char* flatjson_benchmarks::url() const { return "https://github.com/niXman/flatjson"; }
@@ -23,19 +32,18 @@ const char* flatjson_benchmarks::notes() const {
     ;
 }
 
-static flatjson::parser *local_obj = nullptr;
+static thread_local flatjson::parser *local_obj = nullptr;
 
 void flatjson_benchmarks::prepare(io_device *in, std::size_t flags) const {
-    auto *input  = in->input_io<io_type::mmap_streams>();
-    auto pair = input->stream();
+    auto pair = in->read_all();
 
-    bool despaced = (flags & e_json_flags::despaced) != 0;
+    bool despaced = (flags & flatjson_options::despaced) != 0;
     local_obj = flatjson::alloc_parser(pair.first, pair.first + pair.second, despaced);
 }
 
 std::pair<bool, std::string>
 flatjson_benchmarks::parse(io_device *in, std::size_t flags) {
-    bool despaced = (flags & e_json_flags::despaced) != 0;
+    bool despaced = (flags & flatjson_options::despaced) != 0;
     flatjson::parse(local_obj, despaced);
 
     std::string err;
@@ -73,6 +81,172 @@ void flatjson_benchmarks::finish() const {
     local_obj = nullptr;
 }
 
+namespace {
+
+// the document is the flat array of the tokens in the order of the input,
+// each container is followed by its members and closed by the end token
+bool flatjson_is_value(const flatjson::iterator &it) {
+    return flatjson::iter_is_array(it) || flatjson::iter_is_object(it)
+        || flatjson::iter_is_string(it) || flatjson::iter_is_number(it)
+        || flatjson::iter_is_bool(it) || flatjson::iter_is_null(it);
+}
+
+bool flatjson_is_container(const flatjson::iterator &it) {
+    return flatjson::iter_is_array(it) || flatjson::iter_is_object(it);
+}
+
+// the numbers are kept as the text of the input
+double flatjson_number(const flatjson::iterator &it) {
+    const auto str = flatjson::iter_value(it);
+    double res = 0.0;
+    std::from_chars(str.data(), str.data() + str.size(), res);
+
+    return res;
+}
+
+bool flatjson_key_equal(const flatjson::iterator &it, const char *key) {
+    const auto str = flatjson::iter_key(it);
+
+    return str.size() == std::strlen(key) && std::memcmp(str.data(), key, str.size()) == 0;
+}
+
+// calls 'f(member)' for each member of the container 'it' points to, until 'f' returns false.
+// there are no links between the siblings, so the tokens of the nested values are walked through
+template<typename F>
+void flatjson_members(const flatjson::iterator &it, const flatjson::iterator &end, F &&f) {
+    std::size_t depth = 0;
+    for ( auto cur = flatjson::iter_next(it); flatjson::iter_not_equal(cur, end); cur = flatjson::iter_next(cur) ) {
+        if ( !flatjson_is_value(cur) ) {
+            if ( depth == 0 ) {
+                return;
+            }
+            --depth;
+            continue;
+        }
+        if ( depth == 0 && !f(cur) ) {
+            return;
+        }
+        if ( flatjson_is_container(cur) ) {
+            ++depth;
+        }
+    }
+}
+
+bool flatjson_member(const flatjson::iterator &it, const flatjson::iterator &end, const char *key, flatjson::iterator *res) {
+    if ( !flatjson::iter_is_object(it) ) {
+        return false;
+    }
+
+    bool found = false;
+    flatjson_members(it, end, [&](const flatjson::iterator &member) {
+        found = flatjson_key_equal(member, key);
+        if ( found ) {
+            *res = member;
+        }
+
+        return !found;
+    });
+
+    return found;
+}
+
+bool flatjson_favorites(const flatjson::iterator &item, const flatjson::iterator &end, flatjson::iterator *res) {
+    flatjson::iterator person;
+
+    return flatjson_member(item, end, "person", &person) && flatjson_member(person, end, "favorites", res);
+}
+
+} // anon ns
+
+bool flatjson_benchmarks::supports_traverse() const { return true; }
+
+// the whole document is the single pass over the tokens, the lookups walk the tokens of the object
+std::pair<bool, std::string>
+flatjson_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    const auto root = flatjson::iter_begin(local_obj);
+    const auto end = flatjson::iter_end(local_obj);
+    if ( p == traverse_pattern::dfs ) {
+        // the root has no key, the members of the arrays have the empty ones
+        for ( auto it = root; flatjson::iter_not_equal(it, end); it = flatjson::iter_next(it) ) {
+            if ( !flatjson_is_value(it) ) {
+                continue;
+            }
+            ++totals->values;
+            totals->strings += flatjson::iter_key(it).size();
+            if ( flatjson::iter_is_number(it) ) {
+                totals->numbers += flatjson_number(it);
+            } else if ( flatjson::iter_is_string(it) ) {
+                totals->strings += flatjson::iter_value(it).size();
+            }
+        }
+
+        return {true, std::string{}};
+    }
+    if ( !flatjson::iter_is_array(root) ) {
+        return {true, std::string{}};
+    }
+
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            flatjson_members(root, end, [&](const flatjson::iterator &item) {
+                flatjson::iterator favorites, color;
+                if ( flatjson_favorites(item, end, &favorites)
+                    && flatjson_member(favorites, end, "color", &color)
+                    && flatjson::iter_is_string(color) )
+                {
+                    ++totals->values;
+                    totals->strings += flatjson::iter_value(color).size();
+                }
+
+                return true;
+            });
+            break;
+        }
+        case traverse_pattern::arrays: {
+            flatjson_members(root, end, [&](const flatjson::iterator &item) {
+                flatjson::iterator favorites;
+                if ( !flatjson_favorites(item, end, &favorites) ) {
+                    return true;
+                }
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    flatjson::iterator values;
+                    if ( !flatjson_member(favorites, end, key, &values) || !flatjson::iter_is_array(values) ) {
+                        continue;
+                    }
+                    flatjson_members(values, end, [&](const flatjson::iterator &it) {
+                        ++totals->values;
+                        totals->numbers += flatjson_number(it);
+
+                        return true;
+                    });
+                }
+
+                return true;
+            });
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = flatjson::iter_members(root);
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                const auto item = flatjson::iter_at(random_index(i, size), root);
+                flatjson::iterator person, salary;
+                if ( flatjson_member(item, end, "person", &person)
+                    && flatjson_member(person, end, "salary", &salary)
+                    && flatjson::iter_is_number(salary) )
+                {
+                    ++totals->values;
+                    totals->numbers += flatjson_number(salary);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
+}
+
 #if 0
 const std::string& flatjson_benchmarks::name() const
 {
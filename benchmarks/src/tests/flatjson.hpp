@@ -7,6 +7,12 @@ namespace json_benchmarks {
 
 /*************************************************************************************************/
 
+struct flatjson_options {
+    enum {
+        despaced = e_json_flags::library_options << 0 // the input has no spaces, skip the whitespace checks
+    };
+};
+
 struct flatjson_benchmarks: benchmarks {
     virtual ~flatjson_benchmarks() = default;
 
@@ -15,10 +21,14 @@ struct flatjson_benchmarks: benchmarks {
     std::pair<bool, std::string> print(io_device *out, std::size_t flags) override;
     void finish() const override;
 
+    bool supports_traverse() const override;
+    std::pair<bool, std::string> traverse(traverse_pattern p, traverse_totals *totals) override;
+
 //    test_suite_results run_test_suite(const test_suite_files &pathnames) override;
 
     io_type input_io_type() const override;
     io_type output_io_type() const override;
+    std::vector<io_type> input_io_types() const override;
     const char* name() const override;
     const char* url() const override;
     const char* version() const override;
@@ -23,7 +23,7 @@ const char* json11_benchmarks::notes() const {
     ;
 }
 
-static json11::Json *local_obj = nullptr;;
+static thread_local json11::Json *local_obj = nullptr;
 
 void json11_benchmarks::prepare(io_device *in, std::size_t flags) const {
     local_obj = new json11::Json;
@@ -4,12 +4,28 @@
 
 #include <jsoncons/json.hpp>
 #include <jsoncons/json_reader.hpp>
+#include <jsoncons/json_parser.hpp>
+#include <jsoncons/json_decoder.hpp>
 
 namespace json_benchmarks {
 
 io_type jsoncons_benchmarks::input_io_type() const { return io_type::mmap_streams; }
 io_type jsoncons_benchmarks::output_io_type() const { return io_type::string_buffer; }
 
+// the std streams are passed to jsoncons as is, the others are read by read_all()/written by write_all()
+std::vector<io_type> jsoncons_benchmarks::input_io_types() const {
+    return {
+         io_type::string_buffer
+        ,io_type::std_strstreams
+        ,io_type::std_fstreams
+        ,io_type::stdio_streams
+        ,io_type::fd_streams
+        ,io_type::mmap_streams
+    };
+}
+
+std::vector<io_type> jsoncons_benchmarks::output_io_types() const { return input_io_types(); }
+
 const char* jsoncons_benchmarks::name() const { return "jsoncons"; }
 
 const char* jsoncons_benchmarks::url() const { return "https://github.com/danielaparker/jsoncons"; }
@@ -25,25 +41,233 @@ const char* jsoncons_benchmarks::notes() const {
     ;
 }
 
-static jsoncons::json *local_obj = nullptr;
+// the system allocator is measured with the stock jsoncons::json, the others
+// with the same document type parameterized by the harness allocator
+using harness_json = jsoncons::basic_json<char, jsoncons::sorted_policy, harness_std_allocator<char>>;
+
+template<typename J>
+struct jsoncons_state {
+    static thread_local J *obj;
+    // the decoder building the document of the chunked input and of the records
+    static thread_local jsoncons::json_decoder<J> *decoder;
+
+    static void release() {
+        delete obj;
+        obj = nullptr;
+        delete decoder;
+        decoder = nullptr;
+    }
+};
+
+template<typename J>
+thread_local J *jsoncons_state<J>::obj = nullptr;
+template<typename J>
+thread_local jsoncons::json_decoder<J> *jsoncons_state<J>::decoder = nullptr;
+
+// the incremental parser of the chunked input and of the records
+static thread_local jsoncons::json_parser *local_parser = nullptr;
+// the document type, is picked by prepare(), prepare_records() and begin_chunks()
+static thread_local bool local_harness_json = false;
+
+template<typename T>
+struct type_tag {
+    using type = T;
+};
+
+// calls 'f' with the type_tag of the document type picked for the current allocator
+template<typename F>
+decltype(auto) with_json_type(F &&f) {
+    if ( local_harness_json ) {
+        return f(type_tag<harness_json>{});
+    }
+
+    return f(type_tag<jsoncons::json>{});
+}
+
+bool jsoncons_benchmarks::supports_allocator(allocator_kind /*k*/) const { return true; }
 
+// jsoncons rebuilds the storage of the values on each parse, so there is no reuse mode
 void jsoncons_benchmarks::prepare(io_device *in, std::size_t flags) const {
-    local_obj = new jsoncons::json;
+    local_harness_json = current_allocator() != allocator_kind::system;
+    with_json_type([](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        if ( !jsoncons_state<json_type>::obj ) {
+            jsoncons_state<json_type>::obj = new json_type;
+        }
+    });
 }
 
 std::pair<bool, std::string>
 jsoncons_benchmarks::parse(io_device *in, std::size_t flags) {
-    auto *input  = in->input_io<io_type::mmap_streams>();
-    auto pair = input->stream();
+    return with_json_type([in](auto tag) -> std::pair<bool, std::string> {
+        using json_type = typename decltype(tag)::type;
+        auto *local_obj = jsoncons_state<json_type>::obj;
+        std::string err;
+        try {
+            switch ( in->type() ) {
+                case io_type::std_strstreams: {
+                    *local_obj = json_type::parse(in->input_io<io_type::std_strstreams>()->stream());
+                    break;
+                }
+                case io_type::std_fstreams: {
+                    *local_obj = json_type::parse(in->input_io<io_type::std_fstreams>()->stream());
+                    break;
+                }
+                default: {
+                    auto pair = in->read_all();
+                    *local_obj = json_type::parse(pair.first, pair.second);
+                    break;
+                }
+            }
+        } catch (const std::exception &ex) {
+            err = ex.what();
+        }
+
+        if ( !err.empty() ) {
+            return {false, err};
+        }
+
+        return {true, err};
+    });
+}
+
+std::pair<bool, std::string>
+jsoncons_benchmarks::print(io_device *out, std::size_t flags) {
+    return with_json_type([out](auto tag) -> std::pair<bool, std::string> {
+        using json_type = typename decltype(tag)::type;
+        const auto *local_obj = jsoncons_state<json_type>::obj;
+        std::string err;
+        try {
+            switch ( out->type() ) {
+                case io_type::string_buffer: {
+                    local_obj->dump(out->output_io<io_type::string_buffer>()->stream());
+                    break;
+                }
+                case io_type::std_strstreams: {
+                    local_obj->dump(out->output_io<io_type::std_strstreams>()->stream());
+                    break;
+                }
+                case io_type::std_fstreams: {
+                    local_obj->dump(out->output_io<io_type::std_fstreams>()->stream());
+                    break;
+                }
+                default: {
+                    std::string string;
+                    local_obj->dump(string);
+                    if ( !out->write_all(string.data(), string.size()) ) {
+                        err = "write error";
+                    }
+                    break;
+                }
+            }
+        } catch (const std::exception &ex) {
+            err = ex.what();
+        }
+
+        return {err.empty(), std::move(err)};
+    });
+}
+
+void jsoncons_benchmarks::finish() const {
+    release();
+}
+
+void jsoncons_benchmarks::release() const {
+    jsoncons_state<jsoncons::json>::release();
+    jsoncons_state<harness_json>::release();
+    delete local_parser;
+    local_parser = nullptr;
+}
+
+bool jsoncons_benchmarks::supports_records() const { return true; }
+
+// the parser and the decoder are reused for all the records
+void jsoncons_benchmarks::prepare_records(io_device */*in*/, std::size_t /*flags*/) {
+    local_harness_json = current_allocator() != allocator_kind::system;
+    if ( !local_parser ) {
+        local_parser = new jsoncons::json_parser;
+    }
+    with_json_type([](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        if ( !jsoncons_state<json_type>::decoder ) {
+            jsoncons_state<json_type>::decoder = new jsoncons::json_decoder<json_type>;
+        }
+    });
+}
+
+std::pair<bool, std::string>
+jsoncons_benchmarks::parse_records(io_device *in, std::size_t /*flags*/, record_ticks *ticks) {
+    const auto pair = in->read_all();
+
+    std::error_code ec;
+    with_json_type([&](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        auto *local_decoder = jsoncons_state<json_type>::decoder;
+        for_each_record(pair.first, pair.second, [&](const char *ptr, std::size_t size) {
+            local_parser->reinitialize();
+            local_parser->update(ptr, size);
+            local_parser->parse_some(*local_decoder, ec);
+            if ( !ec ) {
+                local_parser->finish_parse(*local_decoder, ec);
+            }
+            if ( !ec ) {
+                local_parser->check_done(ec);
+            }
+            if ( ec ) {
+                return false;
+            }
+            // the record is freed before the tick, as by the other adapters
+            local_decoder->get_result();
+            ticks->tick();
+
+            return true;
+        });
+    });
 
     std::string err;
-    try {
-        *local_obj = jsoncons::json::parse(pair.first, pair.second);
-    } catch (const std::exception &ex) {
-        err = ex.what();
+    if ( ec ) {
+        err = ec.message();
+
+        return {false, err};
     }
 
-    if ( !err.empty() ) {
+    return {true, err};
+}
+
+void jsoncons_benchmarks::finish_records() {
+    release();
+}
+
+bool jsoncons_benchmarks::supports_chunks() const { return true; }
+
+void jsoncons_benchmarks::begin_chunks(std::size_t flags) {
+    local_harness_json = current_allocator() != allocator_kind::system;
+    delete local_parser;
+    local_parser = new jsoncons::json_parser;
+    with_json_type([](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        if ( !jsoncons_state<json_type>::obj ) {
+            jsoncons_state<json_type>::obj = new json_type;
+        }
+        delete jsoncons_state<json_type>::decoder;
+        jsoncons_state<json_type>::decoder = new jsoncons::json_decoder<json_type>;
+    });
+}
+
+// the parser stops at the end of the chunk and resumes with the next one
+std::pair<bool, std::string>
+jsoncons_benchmarks::parse_chunk(const char *ptr, std::size_t size) {
+    std::error_code ec;
+    local_parser->update(ptr, size);
+    with_json_type([&](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        local_parser->parse_some(*jsoncons_state<json_type>::decoder, ec);
+    });
+
+    std::string err;
+    if ( ec ) {
+        err = ec.message();
+
         return {false, err};
     }
 
@@ -51,23 +275,212 @@ jsoncons_benchmarks::parse(io_device *in, std::size_t flags) {
 }
 
 std::pair<bool, std::string>
-jsoncons_benchmarks::print(io_device *out, std::size_t flags) {
-    auto *output = out->output_io<io_type::string_buffer>();
-    auto &string = output->stream();
+jsoncons_benchmarks::finish_chunks() {
+    std::error_code ec;
+    with_json_type([&](auto tag) {
+        using json_type = typename decltype(tag)::type;
+        auto *local_decoder = jsoncons_state<json_type>::decoder;
+        local_parser->finish_parse(*local_decoder, ec);
+        if ( !ec ) {
+            local_parser->check_done(ec);
+        }
+        if ( !ec ) {
+            *jsoncons_state<json_type>::obj = local_decoder->get_result();
+        }
+    });
 
     std::string err;
-    try {
-        local_obj->dump(string);
-    } catch (const std::exception &ex) {
-        err = ex.what();
+    if ( ec ) {
+        err = ec.message();
+
+        return {false, err};
     }
 
-    return {err.empty(), std::move(err)};
+    return {true, err};
 }
 
-void jsoncons_benchmarks::finish() const {
-    delete local_obj;
-    local_obj = nullptr;
+// the visitors return nothing since jsoncons-1.0
+#ifndef JSONCONS_VISITOR_RETURN_TYPE
+#   define JSONCONS_VISITOR_RETURN_TYPE bool
+#   define JSONCONS_VISITOR_RETURN return true
+#endif
+
+namespace {
+
+struct sax_visitor: jsoncons::basic_default_json_visitor<char> {
+    explicit sax_visitor(sax_totals *totals)
+        :totals{totals}
+    {}
+
+    JSONCONS_VISITOR_RETURN_TYPE visit_begin_object(jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_end_object(const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_begin_array(jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_end_array(const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_key(const string_view_type &, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_null(jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_bool(bool, jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_string(const string_view_type &, jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_int64(std::int64_t v, jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; totals->numbers += v; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_uint64(std::uint64_t v, jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; totals->numbers += v; JSONCONS_VISITOR_RETURN; }
+    JSONCONS_VISITOR_RETURN_TYPE visit_double(double v, jsoncons::semantic_tag, const jsoncons::ser_context &, std::error_code &) override
+    { ++totals->events; totals->numbers += v; JSONCONS_VISITOR_RETURN; }
+
+    sax_totals *totals;
+};
+
+} // anon ns
+
+bool jsoncons_benchmarks::supports_sax() const { return true; }
+
+std::pair<bool, std::string>
+jsoncons_benchmarks::sax_parse(io_device *in, std::size_t /*flags*/, sax_totals *totals) {
+    sax_visitor visitor{totals};
+    std::error_code ec;
+    switch ( in->type() ) {
+        case io_type::std_strstreams: {
+            jsoncons::json_stream_reader reader{in->input_io<io_type::std_strstreams>()->stream(), visitor};
+            reader.read(ec);
+            break;
+        }
+        case io_type::std_fstreams: {
+            jsoncons::json_stream_reader reader{in->input_io<io_type::std_fstreams>()->stream(), visitor};
+            reader.read(ec);
+            break;
+        }
+        default: {
+            auto pair = in->read_all();
+            jsoncons::json_string_reader reader{jsoncons::string_view{pair.first, pair.second}, visitor};
+            reader.read(ec);
+            break;
+        }
+    }
+
+    std::string err;
+    if ( ec ) {
+        err = ec.message();
+
+        return {false, err};
+    }
+
+    return {true, err};
+}
+
+namespace {
+
+template<typename J>
+void jsoncons_dfs(const J &val, traverse_totals *totals) {
+    ++totals->values;
+    if ( val.is_number() ) {
+        totals->numbers += val.template as<double>();
+    } else if ( val.is_string() ) {
+        totals->strings += val.as_string_view().size();
+    } else if ( val.is_array() ) {
+        for ( const auto &it: val.array_range() ) {
+            jsoncons_dfs(it, totals);
+        }
+    } else if ( val.is_object() ) {
+        for ( const auto &it: val.object_range() ) {
+            totals->strings += it.key().size();
+            jsoncons_dfs(it.value(), totals);
+        }
+    }
+}
+
+// nullptr when 'val' is nullptr, not an object or has no such key
+template<typename J>
+const J* jsoncons_member(const J *val, jsoncons::string_view key) {
+    if ( !val || !val->is_object() ) {
+        return nullptr;
+    }
+
+    auto it = val->find(key);
+
+    return it == val->object_range().end() ? nullptr : &it->value();
+}
+
+template<typename J>
+const J* jsoncons_favorites(const J &item) {
+    return jsoncons_member(jsoncons_member(&item, "person"), "favorites");
+}
+
+// the keys of the objects are sorted, so find() is the binary search
+template<typename J>
+std::pair<bool, std::string> jsoncons_traverse(const J &root, traverse_pattern p, traverse_totals *totals) {
+    if ( p == traverse_pattern::dfs ) {
+        jsoncons_dfs(root, totals);
+
+        return {true, std::string{}};
+    }
+    if ( !root.is_array() ) {
+        return {true, std::string{}};
+    }
+
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            for ( const auto &item: root.array_range() ) {
+                const auto *color = jsoncons_member(jsoncons_favorites(item), "color");
+                if ( color && color->is_string() ) {
+                    ++totals->values;
+                    totals->strings += color->as_string_view().size();
+                }
+            }
+            break;
+        }
+        case traverse_pattern::arrays: {
+            for ( const auto &item: root.array_range() ) {
+                const auto *favorites = jsoncons_favorites(item);
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    const auto *values = jsoncons_member(favorites, key);
+                    if ( !values || !values->is_array() ) {
+                        continue;
+                    }
+                    for ( const auto &it: values->array_range() ) {
+                        ++totals->values;
+                        totals->numbers += it.template as<double>();
+                    }
+                }
+            }
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = root.size();
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                const auto *salary = jsoncons_member(jsoncons_member(&root[random_index(i, size)], "person"), "salary");
+                if ( salary && salary->is_number() ) {
+                    ++totals->values;
+                    totals->numbers += salary->template as<double>();
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
+}
+
+} // anon ns
+
+bool jsoncons_benchmarks::supports_traverse() const { return true; }
+
+std::pair<bool, std::string>
+jsoncons_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    return with_json_type([p, totals](auto tag) {
+        using json_type = typename decltype(tag)::type;
+
+        return jsoncons_traverse(*jsoncons_state<json_type>::obj, p, totals);
+    });
 }
 
 #if 0
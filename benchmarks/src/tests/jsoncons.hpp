@@ -15,10 +15,31 @@ struct jsoncons_benchmarks: benchmarks {
     std::pair<bool, std::string> print(io_device *out, std::size_t flags) override;
     void finish() const override;
 
+    bool supports_sax() const override;
+    std::pair<bool, std::string> sax_parse(io_device *in, std::size_t flags, sax_totals *totals) override;
+
+    bool supports_chunks() const override;
+    void begin_chunks(std::size_t flags) override;
+    std::pair<bool, std::string> parse_chunk(const char *ptr, std::size_t size) override;
+    std::pair<bool, std::string> finish_chunks() override;
+
+    bool supports_allocator(allocator_kind k) const override;
+    void release() const override;
+
+    bool supports_records() const override;
+    void prepare_records(io_device *in, std::size_t flags) override;
+    std::pair<bool, std::string> parse_records(io_device *in, std::size_t flags, record_ticks *ticks) override;
+    void finish_records() override;
+
+    bool supports_traverse() const override;
+    std::pair<bool, std::string> traverse(traverse_pattern p, traverse_totals *totals) override;
+
 //    test_suite_results run_test_suite(const test_suite_files &pathnames) override;
 
     io_type input_io_type() const override;
     io_type output_io_type() const override;
+    std::vector<io_type> input_io_types() const override;
+    std::vector<io_type> output_io_types() const override;
     const char* name() const override;
     const char* url() const override;
     const char* version() const override;
@@ -4,6 +4,8 @@
 
 #include <json/json.h>
 
+#include <cstring>
+
 namespace json_benchmarks {
 
 io_type jsoncpp_benchmarks::input_io_type() const { return io_type::string_buffer; }
@@ -24,7 +26,7 @@ const char* jsoncpp_benchmarks::notes() const {
     ;
 }
 
-static Json::Value *local_obj = nullptr;
+static thread_local Json::Value *local_obj = nullptr;
 
 void jsoncpp_benchmarks::prepare(io_device *in, std::size_t flags) const {
     local_obj = new Json::Value;
@@ -36,7 +38,6 @@ jsoncpp_benchmarks::parse(io_device *in, std::size_t flags) {
     auto &string = input->stream();
 
     Json::Reader reader;
-    auto pair = input->stream();
     if ( !reader.parse(string.data(), string.data() + string.length(), *local_obj) ) {
         auto err = reader.getFormattedErrorMessages();
 
@@ -70,6 +71,118 @@ void jsoncpp_benchmarks::finish() const {
     local_obj = nullptr;
 }
 
+namespace {
+
+void jsoncpp_dfs(const Json::Value &val, traverse_totals *totals) {
+    ++totals->values;
+    switch ( val.type() ) {
+        case Json::intValue:
+        case Json::uintValue:
+        case Json::realValue:
+            totals->numbers += val.asDouble();
+            break;
+        case Json::stringValue: {
+            const char *beg, *end;
+            if ( val.getString(&beg, &end) ) {
+                totals->strings += end - beg;
+            }
+            break;
+        }
+        case Json::arrayValue:
+            for ( const auto &it: val ) {
+                jsoncpp_dfs(it, totals);
+            }
+            break;
+        case Json::objectValue:
+            for ( auto it = val.begin(); it != val.end(); ++it ) {
+                const char *end;
+                const char *beg = it.memberName(&end);
+                totals->strings += end - beg;
+                jsoncpp_dfs(*it, totals);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// nullptr when 'val' is nullptr, not an object or has no such key
+const Json::Value* jsoncpp_member(const Json::Value *val, const char *key) {
+    if ( !val || !val->isObject() ) {
+        return nullptr;
+    }
+
+    return val->find(key, key + std::strlen(key));
+}
+
+const Json::Value* jsoncpp_favorites(const Json::Value &item) {
+    return jsoncpp_member(jsoncpp_member(&item, "person"), "favorites");
+}
+
+} // anon ns
+
+bool jsoncpp_benchmarks::supports_traverse() const { return true; }
+
+// both the arrays and the objects are std::map's, so each access is the tree search
+std::pair<bool, std::string>
+jsoncpp_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    const auto &root = *local_obj;
+    if ( p == traverse_pattern::dfs ) {
+        jsoncpp_dfs(root, totals);
+
+        return {true, std::string{}};
+    }
+    if ( !root.isArray() ) {
+        return {true, std::string{}};
+    }
+
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            for ( const auto &item: root ) {
+                const auto *color = jsoncpp_member(jsoncpp_favorites(item), "color");
+                const char *beg, *end;
+                if ( color && color->isString() && color->getString(&beg, &end) ) {
+                    ++totals->values;
+                    totals->strings += end - beg;
+                }
+            }
+            break;
+        }
+        case traverse_pattern::arrays: {
+            for ( const auto &item: root ) {
+                const auto *favorites = jsoncpp_favorites(item);
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    const auto *values = jsoncpp_member(favorites, key);
+                    if ( !values || !values->isArray() ) {
+                        continue;
+                    }
+                    for ( const auto &it: *values ) {
+                        ++totals->values;
+                        totals->numbers += it.asDouble();
+                    }
+                }
+            }
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = static_cast<std::size_t>(root.size());
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                const auto &item = root[static_cast<Json::ArrayIndex>(random_index(i, size))];
+                const auto *salary = jsoncpp_member(jsoncpp_member(&item, "person"), "salary");
+                if ( salary && salary->isNumeric() ) {
+                    ++totals->values;
+                    totals->numbers += salary->asDouble();
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
+}
+
 //std::vector<test_suite_result> jsoncpp_benchmarks::run_test_suite(std::vector<test_suite_file>& pathnames)
 //{
 //    std::vector<test_suite_result> results;
@@ -9,6 +9,20 @@ namespace json_benchmarks {
 io_type simdjson_benchmarks::input_io_type() const { return io_type::mmap_streams; }
 io_type simdjson_benchmarks::output_io_type() const { return io_type::string_buffer; }
 
+// the parser copies the input into its padded buffer when it's needed, so any device fits
+std::vector<io_type> simdjson_benchmarks::input_io_types() const {
+    return {
+         io_type::string_buffer
+        ,io_type::std_strstreams
+        ,io_type::std_fstreams
+        ,io_type::stdio_streams
+        ,io_type::fd_streams
+        ,io_type::mmap_streams
+    };
+}
+
+std::vector<io_type> simdjson_benchmarks::output_io_types() const { return input_io_types(); }
+
 const char* simdjson_benchmarks::name() const { return "simdjson"; }
 
 const char* simdjson_benchmarks::url() const { return "https://github.com/simdjson/simdjson"; }
@@ -21,20 +35,28 @@ const char* simdjson_benchmarks::notes() const {
     ;
 }
 
-simdjson::dom::element *local_obj = nullptr;
+// the element refers to the memory of the parser, so both live until finish()
+static thread_local simdjson::dom::parser *local_parser = nullptr;
+static thread_local simdjson::dom::element *local_obj = nullptr;
+static thread_local bool local_reuse = false;
+
+bool simdjson_benchmarks::supports_reuse() const { return true; }
 
-void simdjson_benchmarks::prepare(io_device */*in*/, std::size_t /*flags*/) const {
-    local_obj = new simdjson::dom::element;
+// the parser keeps its buffers sized for the largest document parsed so far
+void simdjson_benchmarks::prepare(io_device */*in*/, std::size_t flags) const {
+    local_reuse = (flags & e_json_flags::reuse) != 0;
+    if ( !local_parser ) {
+        local_parser = new simdjson::dom::parser;
+        local_obj = new simdjson::dom::element;
+    }
 }
 
 std::pair<bool, std::string>
 simdjson_benchmarks::parse(io_device *in, std::size_t flags) {
-    auto *istream  = in->input_io<io_type::mmap_streams>();
-    const auto pair = istream->stream();
+    const auto pair = in->read_all();
 
-    simdjson::dom::parser parser;
     simdjson::error_code error;
-    parser.parse(pair.first, pair.second).tie(*local_obj, error);
+    local_parser->parse(pair.first, pair.second).tie(*local_obj, error);
 
     std::string err;
     if ( error != simdjson::SUCCESS ) {
@@ -48,19 +70,160 @@ simdjson_benchmarks::parse(io_device *in, std::size_t flags) {
 
 std::pair<bool, std::string>
 simdjson_benchmarks::print(io_device *out, std::size_t flags) {
-    auto *ostream = out->output_io<io_type::string_buffer>();
-    auto &string = ostream->stream();
-
     auto str = simdjson::to_string(*local_obj);
-    string.assign(str.data(), str.size());
-
     std::string err;
+    if ( !out->write_all(str.data(), str.size()) ) {
+        err = "write error";
+
+        return {false, err};
+    }
+
     return {true, err};
 }
 
 void simdjson_benchmarks::finish() const {
+    if ( !local_reuse ) {
+        release();
+    }
+}
+
+void simdjson_benchmarks::release() const {
     delete local_obj;
     local_obj = nullptr;
+    delete local_parser;
+    local_parser = nullptr;
+}
+
+// parse_many() requires the padded input
+static thread_local simdjson::padded_string *local_records = nullptr;
+
+bool simdjson_benchmarks::supports_records() const { return true; }
+
+void simdjson_benchmarks::prepare_records(io_device *in, std::size_t flags) {
+    prepare(in, flags);
+
+    const auto pair = in->read_all();
+    delete local_records;
+    local_records = new simdjson::padded_string{pair.first, pair.second};
+}
+
+// the records are parsed by the batches of the stream, one document at a time
+std::pair<bool, std::string>
+simdjson_benchmarks::parse_records(io_device */*in*/, std::size_t /*flags*/, record_ticks *ticks) {
+    simdjson::dom::document_stream stream;
+    auto error = local_parser->parse_many(*local_records).get(stream);
+    if ( error != simdjson::SUCCESS ) {
+        return {false, simdjson::error_message(error)};
+    }
+
+    for ( auto doc: stream ) {
+        simdjson::dom::element element;
+        error = doc.get(element);
+        if ( error != simdjson::SUCCESS ) {
+            return {false, simdjson::error_message(error)};
+        }
+        ticks->tick();
+    }
+
+    return {true, std::string{}};
+}
+
+void simdjson_benchmarks::finish_records() {
+    delete local_records;
+    local_records = nullptr;
+    release();
+}
+
+namespace {
+
+void simdjson_dfs(simdjson::dom::element val, traverse_totals *totals) {
+    ++totals->values;
+    switch ( val.type() ) {
+        case simdjson::dom::element_type::INT64:
+        case simdjson::dom::element_type::UINT64:
+        case simdjson::dom::element_type::DOUBLE:
+            totals->numbers += val.get_double().value_unsafe();
+            break;
+        case simdjson::dom::element_type::STRING:
+            totals->strings += val.get_string().value_unsafe().size();
+            break;
+        case simdjson::dom::element_type::ARRAY:
+            for ( auto it: val.get_array().value_unsafe() ) {
+                simdjson_dfs(it, totals);
+            }
+            break;
+        case simdjson::dom::element_type::OBJECT:
+            for ( auto it: val.get_object().value_unsafe() ) {
+                totals->strings += it.key.size();
+                simdjson_dfs(it.value, totals);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+} // anon ns
+
+bool simdjson_benchmarks::supports_traverse() const { return true; }
+
+// the lookups of the missing keys are reported by the error codes, so they are just skipped.
+// the elements of the tape are stored in place, so the array::at() walks the array
+std::pair<bool, std::string>
+simdjson_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    if ( p == traverse_pattern::dfs ) {
+        simdjson_dfs(*local_obj, totals);
+
+        return {true, std::string{}};
+    }
+
+    simdjson::dom::array root;
+    if ( local_obj->get(root) != simdjson::SUCCESS ) {
+        return {true, std::string{}};
+    }
+
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            for ( auto item: root ) {
+                std::string_view color;
+                if ( item["person"]["favorites"]["color"].get(color) == simdjson::SUCCESS ) {
+                    ++totals->values;
+                    totals->strings += color.size();
+                }
+            }
+            break;
+        }
+        case traverse_pattern::arrays: {
+            for ( auto item: root ) {
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    simdjson::dom::array values;
+                    if ( item["person"]["favorites"][key].get(values) != simdjson::SUCCESS ) {
+                        continue;
+                    }
+                    for ( auto it: values ) {
+                        ++totals->values;
+                        totals->numbers += it.get_double().value_unsafe();
+                    }
+                }
+            }
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = root.size();
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                double salary;
+                if ( root.at(random_index(i, size))["person"]["salary"].get(salary) == simdjson::SUCCESS ) {
+                    ++totals->values;
+                    totals->numbers += salary;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
 }
 
 #if 0
@@ -15,10 +15,23 @@ struct simdjson_benchmarks: benchmarks {
     std::pair<bool, std::string> print(io_device *out, std::size_t flags) override;
     void finish() const override;
 
+    bool supports_reuse() const override;
+    void release() const override;
+
+    bool supports_records() const override;
+    void prepare_records(io_device *in, std::size_t flags) override;
+    std::pair<bool, std::string> parse_records(io_device *in, std::size_t flags, record_ticks *ticks) override;
+    void finish_records() override;
+
+    bool supports_traverse() const override;
+    std::pair<bool, std::string> traverse(traverse_pattern p, traverse_totals *totals) override;
+
 //    test_suite_results run_test_suite(const test_suite_files &pathnames) override;
 
     io_type input_io_type() const override;
     io_type output_io_type() const override;
+    std::vector<io_type> input_io_types() const override;
+    std::vector<io_type> output_io_types() const override;
     const char* name() const override;
     const char* url() const override;
     const char* version() const override;
@@ -23,7 +23,7 @@ const char* taojson_benchmarks::notes() const {
     ;
 }
 
-static tao::json::value *local_obj = nullptr;
+static thread_local tao::json::value *local_obj = nullptr;
 
 void taojson_benchmarks::prepare(io_device *in, std::size_t flags) const {
     local_obj = new tao::json::value;
@@ -68,6 +68,51 @@ void taojson_benchmarks::finish() const {
     local_obj = nullptr;
 }
 
+namespace {
+
+// the consumer of the tao::json events
+struct sax_consumer {
+    void null() { ++totals->events; }
+    void boolean(const bool) { ++totals->events; }
+    void number(const std::int64_t v) { ++totals->events; totals->numbers += v; }
+    void number(const std::uint64_t v) { ++totals->events; totals->numbers += v; }
+    void number(const double v) { ++totals->events; totals->numbers += v; }
+    void string(const std::string_view) { ++totals->events; }
+    void binary(const tao::binary_view) { ++totals->events; }
+    void begin_array(const std::size_t = 0) { ++totals->events; }
+    void element() {}
+    void end_array(const std::size_t = 0) { ++totals->events; }
+    void begin_object(const std::size_t = 0) { ++totals->events; }
+    void key(const std::string_view) { ++totals->events; }
+    void member() {}
+    void end_object(const std::size_t = 0) { ++totals->events; }
+
+    sax_totals *totals;
+};
+
+} // anon ns
+
+bool taojson_benchmarks::supports_sax() const { return true; }
+
+std::pair<bool, std::string>
+taojson_benchmarks::sax_parse(io_device *in, std::size_t /*flags*/, sax_totals *totals) {
+    auto pair = in->read_all();
+
+    std::string err;
+    try {
+        sax_consumer consumer{totals};
+        tao::json::events::from_string(consumer, pair.first, pair.second);
+    } catch (const std::exception &ex) {
+        err = ex.what();
+    }
+
+    if ( !err.empty() ) {
+        return {false, err};
+    }
+
+    return {true, err};
+}
+
 #if 0
 const std::string& taojson_benchmarks::name() const
 {
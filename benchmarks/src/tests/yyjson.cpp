@@ -4,11 +4,29 @@
 
 #include <yyjson.h>
 
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
 namespace json_benchmarks {
 
 io_type yyjson_benchmarks::input_io_type() const { return io_type::mmap_streams; }
 io_type yyjson_benchmarks::output_io_type() const { return io_type::string_buffer; }
 
+// the input is taken by read_all() and the output is written by write_all(), so any device fits
+std::vector<io_type> yyjson_benchmarks::input_io_types() const {
+    return {
+         io_type::string_buffer
+        ,io_type::std_strstreams
+        ,io_type::std_fstreams
+        ,io_type::stdio_streams
+        ,io_type::fd_streams
+        ,io_type::mmap_streams
+    };
+}
+
+std::vector<io_type> yyjson_benchmarks::output_io_types() const { return input_io_types(); }
+
 const char* yyjson_benchmarks::name() const { return "yyjson"; }
 
 const char* yyjson_benchmarks::url() const { return "https://github.com/ibireme/yyjson"; }
@@ -21,18 +39,69 @@ const char* yyjson_benchmarks::notes() const {
     ;
 }
 
-static yyjson_doc *local_obj = nullptr;
+static thread_local yyjson_doc *local_obj = nullptr;
+// the reuse mode reads into the same buffer sized for the input
+static thread_local char *local_pool = nullptr;
+static thread_local std::size_t local_pool_size = 0;
+// the insitu option parses the mutable copy of the input with the padding yyjson requires
+static thread_local std::vector<char> *local_insitu = nullptr;
+
+bool yyjson_benchmarks::supports_allocator(allocator_kind /*k*/) const { return true; }
 
-void yyjson_benchmarks::prepare(io_device */*in*/, std::size_t /*flags*/) const {
+bool yyjson_benchmarks::supports_reuse() const { return true; }
+
+static const yyjson_alc harness_alc = {
+     [](void */*ctx*/, std::size_t size) { return harness_malloc(size); }
+    ,[](void */*ctx*/, void *ptr, std::size_t old_size, std::size_t size) { return harness_realloc(ptr, old_size, size); }
+    ,[](void */*ctx*/, void *ptr) { harness_free(ptr); }
+    ,nullptr
+};
+
+// nullptr means the default malloc()/realloc()/free() ones
+static const yyjson_alc* current_alc() {
+    return current_allocator() == allocator_kind::system ? nullptr : &harness_alc;
+}
+
+void yyjson_benchmarks::prepare(io_device *in, std::size_t flags) const {
+    const auto pair = in->read_all();
+
+    // the previous trial has modified the copy, so it's made each time
+    if ( flags & yyjson_options::insitu ) {
+        if ( !local_insitu ) {
+            local_insitu = new std::vector<char>;
+        }
+        local_insitu->resize(pair.second + YYJSON_PADDING_SIZE);
+        std::memcpy(local_insitu->data(), pair.first, pair.second);
+        std::memset(local_insitu->data() + pair.second, 0, YYJSON_PADDING_SIZE);
+    }
+
+    if ( flags & e_json_flags::reuse ) {
+        const auto needed = yyjson_read_max_memory_usage(pair.second, 0);
+        if ( local_pool_size < needed ) {
+            free(local_pool);
+            local_pool = static_cast<char *>(malloc(needed));
+            local_pool_size = local_pool ? needed : 0;
+        }
+    }
 }
 
 std::pair<bool, std::string>
 yyjson_benchmarks::parse(io_device *in, std::size_t flags) {
-    auto *istream  = in->input_io<io_type::mmap_streams>();
-    auto pair = istream->stream();
+    auto pair = in->read_all();
+
+    // the document keeps the copy of the pool allocator, which takes precedence over the harness one
+    yyjson_alc pool_alc;
+    const auto *alc = current_alc();
+    if ( (flags & e_json_flags::reuse) && yyjson_alc_pool_init(&pool_alc, local_pool, local_pool_size) ) {
+        alc = &pool_alc;
+    }
 
     yyjson_read_err errv;
-    local_obj = yyjson_read_opts(pair.first, pair.second, 0, nullptr, &errv);
+    if ( flags & yyjson_options::insitu ) {
+        local_obj = yyjson_read_opts(local_insitu->data(), pair.second, YYJSON_READ_INSITU, alc, &errv);
+    } else {
+        local_obj = yyjson_read_opts(const_cast<char *>(pair.first), pair.second, 0, alc, &errv);
+    }
 
     std::string err;
     if ( errv.code != YYJSON_READ_SUCCESS ) {
@@ -46,11 +115,9 @@ yyjson_benchmarks::parse(io_device *in, std::size_t flags) {
 
 std::pair<bool, std::string>
 yyjson_benchmarks::print(io_device *out, std::size_t flags) {
-    auto *ostream = out->output_io<io_type::string_buffer>();
-    auto &string = ostream->stream();
-
     std::size_t written;
-    char *ptr = yyjson_write(local_obj, 0, &written);
+    const auto *alc = current_alc();
+    char *ptr = yyjson_write_opts(local_obj, 0, alc, &written, nullptr);
 
     std::string err;
     if ( !ptr ) {
@@ -59,14 +126,188 @@ yyjson_benchmarks::print(io_device *out, std::size_t flags) {
         return {false, err};
     }
 
-    string = ptr;
-    free(ptr);
+    const bool ok = out->write_all(ptr, written);
+    if ( alc ) {
+        alc->free(alc->ctx, ptr);
+    } else {
+        free(ptr);
+    }
+    if ( !ok ) {
+        err = "write error";
+    }
 
-    return {true, err};
+    return {ok, err};
 }
 
 void yyjson_benchmarks::finish() const {
     yyjson_doc_free(local_obj);
+    local_obj = nullptr;
+}
+
+void yyjson_benchmarks::release() const {
+    free(local_pool);
+    local_pool = nullptr;
+    local_pool_size = 0;
+    delete local_insitu;
+    local_insitu = nullptr;
+}
+
+// the insitu copy is sized by the first trial and freed by release() only
+bool yyjson_benchmarks::retains_storage(std::size_t flags) const {
+    return (flags & (e_json_flags::reuse | yyjson_options::insitu)) != 0;
+}
+
+bool yyjson_benchmarks::supports_records() const { return true; }
+
+// each record is read into the same pool sized for the longest one, so the reading allocates nothing
+void yyjson_benchmarks::prepare_records(io_device *in, std::size_t /*flags*/) {
+    const auto pair = in->read_all();
+
+    std::size_t longest = 0;
+    for_each_record(pair.first, pair.second, [&longest](const char *, std::size_t size) {
+        longest = std::max(longest, size);
+
+        return true;
+    });
+
+    const auto needed = yyjson_read_max_memory_usage(longest, 0);
+    if ( local_pool_size < needed ) {
+        free(local_pool);
+        local_pool = static_cast<char *>(malloc(needed));
+        local_pool_size = local_pool ? needed : 0;
+    }
+}
+
+std::pair<bool, std::string>
+yyjson_benchmarks::parse_records(io_device *in, std::size_t /*flags*/, record_ticks *ticks) {
+    const auto pair = in->read_all();
+
+    yyjson_alc pool_alc;
+    if ( !yyjson_alc_pool_init(&pool_alc, local_pool, local_pool_size) ) {
+        return {false, "can't initialize the pool allocator"};
+    }
+
+    std::string err;
+    for_each_record(pair.first, pair.second, [&](const char *ptr, std::size_t size) {
+        yyjson_read_err errv;
+        auto *doc = yyjson_read_opts(const_cast<char *>(ptr), size, 0, &pool_alc, &errv);
+        if ( !doc ) {
+            err = errv.msg;
+
+            return false;
+        }
+        yyjson_doc_free(doc);
+        ticks->tick();
+
+        return true;
+    });
+
+    return {err.empty(), std::move(err)};
+}
+
+void yyjson_benchmarks::finish_records() {
+    release();
+}
+
+namespace {
+
+void yyjson_dfs(yyjson_val *val, traverse_totals *totals) {
+    ++totals->values;
+    switch ( yyjson_get_type(val) ) {
+        case YYJSON_TYPE_NUM:
+            totals->numbers += yyjson_get_num(val);
+            break;
+        case YYJSON_TYPE_STR:
+            totals->strings += yyjson_get_len(val);
+            break;
+        case YYJSON_TYPE_ARR: {
+            std::size_t idx, max;
+            yyjson_val *it;
+            yyjson_arr_foreach(val, idx, max, it) {
+                yyjson_dfs(it, totals);
+            }
+            break;
+        }
+        case YYJSON_TYPE_OBJ: {
+            std::size_t idx, max;
+            yyjson_val *key, *it;
+            yyjson_obj_foreach(val, idx, max, key, it) {
+                totals->strings += yyjson_get_len(key);
+                yyjson_dfs(it, totals);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// yyjson_obj_get() returns nullptr for nullptr or a non-object, so the lookups are chained as is
+yyjson_val* yyjson_favorites(yyjson_val *item) {
+    return yyjson_obj_get(yyjson_obj_get(item, "person"), "favorites");
+}
+
+} // anon ns
+
+bool yyjson_benchmarks::supports_traverse() const { return true; }
+
+// the elements of the immutable document are stored in place, so yyjson_arr_get() walks the array
+std::pair<bool, std::string>
+yyjson_benchmarks::traverse(traverse_pattern p, traverse_totals *totals) {
+    auto *root = yyjson_doc_get_root(local_obj);
+    if ( p == traverse_pattern::dfs ) {
+        yyjson_dfs(root, totals);
+
+        return {true, std::string{}};
+    }
+    if ( !yyjson_is_arr(root) ) {
+        return {true, std::string{}};
+    }
+
+    std::size_t idx, max;
+    yyjson_val *item;
+    switch ( p ) {
+        case traverse_pattern::lookup: {
+            yyjson_arr_foreach(root, idx, max, item) {
+                auto *color = yyjson_obj_get(yyjson_favorites(item), "color");
+                if ( yyjson_is_str(color) ) {
+                    ++totals->values;
+                    totals->strings += yyjson_get_len(color);
+                }
+            }
+            break;
+        }
+        case traverse_pattern::arrays: {
+            yyjson_arr_foreach(root, idx, max, item) {
+                auto *favorites = yyjson_favorites(item);
+                for ( const auto *key: {"integer_values", "double_values"} ) {
+                    std::size_t vidx, vmax;
+                    yyjson_val *it;
+                    yyjson_arr_foreach(yyjson_obj_get(favorites, key), vidx, vmax, it) {
+                        ++totals->values;
+                        totals->numbers += yyjson_get_num(it);
+                    }
+                }
+            }
+            break;
+        }
+        case traverse_pattern::random: {
+            const auto size = yyjson_arr_size(root);
+            for ( std::size_t i = 0; size && i < traverse_random_accesses; ++i ) {
+                item = yyjson_arr_get(root, random_index(i, size));
+                auto *salary = yyjson_obj_get(yyjson_obj_get(item, "person"), "salary");
+                if ( yyjson_is_num(salary) ) {
+                    ++totals->values;
+                    totals->numbers += yyjson_get_num(salary);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return {true, std::string{}};
 }
 
 #if 0
@@ -0,0 +1,171 @@
+
+#include "timer.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   include <cpuid.h>
+#   define JSON_BENCHMARKS_HAS_TSC
+#endif
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+namespace {
+
+std::uint64_t monotonic_raw_ns() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+#ifdef JSON_BENCHMARKS_HAS_TSC
+bool tsc_is_invariant() {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if ( !__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) || eax < 0x80000007u ) {
+        return false;
+    }
+    if ( !__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) ) {
+        return false;
+    }
+
+    // CPUID.80000007H:EDX[8] - invariant TSC
+    return (edx & (1u << 8)) != 0;
+}
+
+// the fences keep rdtsc from being reordered with the measured code
+inline std::uint64_t read_tsc() {
+    _mm_lfence();
+    std::uint64_t v = __rdtsc();
+    _mm_lfence();
+
+    return v;
+}
+
+// the TSC rate in Hz, measured against CLOCK_MONOTONIC_RAW over the 'window_ns' period
+double measure_tsc_hz(std::uint64_t window_ns) {
+    auto ns0 = monotonic_raw_ns();
+    auto t0 = read_tsc();
+    while ( monotonic_raw_ns() - ns0 < window_ns )
+    {}
+    auto t1 = read_tsc();
+    auto ns1 = monotonic_raw_ns();
+
+    return static_cast<double>(t1 - t0) * 1e9 / static_cast<double>(ns1 - ns0);
+}
+#endif // JSON_BENCHMARKS_HAS_TSC
+
+struct calibration {
+    calibration()
+        :src{clock_source::monotonic_raw}
+        ,ns_per_tick{1.0}
+        ,hz{0}
+        ,overhead{0}
+    {
+#ifdef JSON_BENCHMARKS_HAS_TSC
+        if ( tsc_is_invariant() ) {
+            // three independent 20ms windows must agree within 0.5%,
+            // otherwise the TSC is considered unreliable on this machine.
+            double rates[3];
+            for ( auto &it: rates ) {
+                it = measure_tsc_hz(20u * 1000u * 1000u);
+            }
+            std::sort(std::begin(rates), std::end(rates));
+
+            const double median = rates[1];
+            const bool stable = median > 0
+                && std::fabs(rates[0] - median) / median < 0.005
+                && std::fabs(rates[2] - median) / median < 0.005
+            ;
+            if ( stable ) {
+                src = clock_source::tsc;
+                ns_per_tick = 1e9 / median;
+                hz = static_cast<std::uint64_t>(median);
+            }
+        }
+#endif // JSON_BENCHMARKS_HAS_TSC
+
+        // the minimum over many back-to-back reads is the timer's own cost
+        std::uint64_t min_ticks = ~0ull;
+        for ( auto i = 0u; i < 10000u; ++i ) {
+            auto t0 = read();
+            auto t1 = read();
+            min_ticks = std::min(min_ticks, t1 - t0);
+        }
+        overhead = static_cast<std::uint64_t>(min_ticks * ns_per_tick);
+    }
+
+    std::uint64_t read() const {
+#ifdef JSON_BENCHMARKS_HAS_TSC
+        if ( src == clock_source::tsc ) {
+            return read_tsc();
+        }
+#endif // JSON_BENCHMARKS_HAS_TSC
+
+        return monotonic_raw_ns();
+    }
+
+    clock_source src;
+    double ns_per_tick;
+    std::uint64_t hz;
+    std::uint64_t overhead; // in nanoseconds
+};
+
+const calibration& get_calibration() {
+    static const calibration c;
+
+    return c;
+}
+
+} // anon ns
+
+/*************************************************************************************************/
+
+const char* clock_source_name(clock_source src) {
+    switch ( src ) {
+        case clock_source::tsc: return "TSC";
+        case clock_source::monotonic_raw: return "CLOCK_MONOTONIC_RAW";
+    }
+
+    return "UNKNOWN";
+}
+
+/*************************************************************************************************/
+
+std::uint64_t phase_timer::now() {
+    return get_calibration().read();
+}
+
+std::uint64_t phase_timer::to_ns(std::uint64_t ticks) {
+    const auto &c = get_calibration();
+
+    return c.src == clock_source::tsc
+        ? static_cast<std::uint64_t>(ticks * c.ns_per_tick)
+        : ticks
+    ;
+}
+
+std::uint64_t phase_timer::elapsed_ns(std::uint64_t start) {
+    auto stop = now();
+    auto ns = to_ns(stop - start);
+    auto overhead = get_calibration().overhead;
+
+    return ns > overhead ? ns - overhead : 0;
+}
+
+clock_source phase_timer::source() { return get_calibration().src; }
+
+std::uint64_t phase_timer::tsc_hz() { return get_calibration().hz; }
+
+std::uint64_t phase_timer::overhead_ns() { return get_calibration().overhead; }
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
@@ -0,0 +1,40 @@
+#ifndef JSON_BENCHMARKS_TIMER_HPP
+#define JSON_BENCHMARKS_TIMER_HPP
+
+#include <cstdint>
+
+namespace json_benchmarks {
+
+/*************************************************************************************************/
+
+enum class clock_source {
+     tsc           // rdtsc, calibrated against CLOCK_MONOTONIC_RAW
+    ,monotonic_raw // clock_gettime(CLOCK_MONOTONIC_RAW)
+};
+
+const char* clock_source_name(clock_source src);
+
+// the timing engine used for every benchmark phase.
+// calibration is performed once, on the first use.
+// the TSC is used only when it is invariant and its rate agrees with
+// CLOCK_MONOTONIC_RAW, otherwise clock_gettime() is used.
+struct phase_timer {
+    // raw ticks of the selected clock source
+    static std::uint64_t now();
+    // converts raw ticks to nanoseconds
+    static std::uint64_t to_ns(std::uint64_t ticks);
+    // elapsed nanoseconds since 'start' minus the timer's own overhead
+    static std::uint64_t elapsed_ns(std::uint64_t start);
+
+    static clock_source source();
+    // TSC frequency in Hz, zero when the TSC is not used
+    static std::uint64_t tsc_hz();
+    // the measured cost of a back-to-back now()/now() pair, in nanoseconds
+    static std::uint64_t overhead_ns();
+};
+
+/*************************************************************************************************/
+
+} // ns json_benchmarks
+
+#endif // JSON_BENCHMARKS_TIMER_HPP